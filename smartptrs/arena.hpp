@@ -0,0 +1,177 @@
+/*******************************************************************************
+ * arena.hpp
+ * Monotonic (bump) arena for batch-scoped object graphs
+ *
+ * A request that builds a graph of nodes or shapes and throws the whole
+ * thing away at the end doesn't need a delete per object, nor reference
+ * counting between the nodes. monotonic_arena bump-allocates from large
+ * chunks and reclaims everything at once in reset().
+ *
+ * OWNERSHIP MODES:
+ *   - create<T>(args...)  arena-owned; raw T* valid until reset(). If T is
+ *                         not trivially destructible its destructor is
+ *                         recorded and run by reset(), newest first.
+ *   - make<T>(args...)    arena_ptr<T> = unique_ptr<T, arena_deleter>.
+ *                         Dropping the handle runs ~T() right away; the
+ *                         memory still comes back only at reset(). The
+ *                         deleter is stateless in release builds, so the
+ *                         handle is one word and converts like unique_ptr
+ *                         (arena_ptr<Circle> -> arena_ptr<Shape>).
+ *
+ * reset() keeps the chunks for the next batch; the destructor frees them.
+ * Handles must not outlive reset() - debug builds assert that none are
+ * outstanding. An arena is not thread-safe: use one per batch/thread.
+ ******************************************************************************/
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace smartptrs {
+
+class monotonic_arena;
+
+// Destroys but does not free: the arena reclaims the memory in bulk
+struct arena_deleter {
+#ifndef NDEBUG
+    monotonic_arena* arena = nullptr;
+#endif
+    template<typename T>
+    void operator()(T* p) const noexcept;
+};
+
+template<typename T>
+using arena_ptr = std::unique_ptr<T, arena_deleter>;
+
+#ifdef NDEBUG
+static_assert(sizeof(arena_ptr<int>) == sizeof(int*), "arena_ptr must stay one word");
+#endif
+
+class monotonic_arena {
+public:
+    explicit monotonic_arena(std::size_t chunkSize = 64 * 1024) : chunkSize_(chunkSize) {}
+    monotonic_arena(const monotonic_arena&) = delete;
+    monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+    ~monotonic_arena() {
+        reset();
+        for (Chunk& c : chunks_) ::operator delete(c.data);
+    }
+
+    void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+        for (;;) {
+            if (current_ < chunks_.size()) {
+                Chunk& c = chunks_[current_];
+                const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(c.data);
+                const std::uintptr_t at = (base + offset_ + align - 1) & ~(std::uintptr_t(align) - 1);
+                if (at + bytes <= base + c.size) {
+                    offset_ = at + bytes - base;
+                    used_ += bytes;
+                    return reinterpret_cast<void*>(at);
+                }
+                if (current_ + 1 < chunks_.size()) {
+                    ++current_; // try the next retained chunk
+                    offset_ = 0;
+                    continue;
+                }
+            }
+            addChunk(bytes + align);
+        }
+    }
+
+    // Arena-owned object, destroyed by reset()
+    template<typename T, typename... Args>
+    T* create(Args&&... args) {
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        } else {
+            auto* rec = static_cast<DtorRecord*>(allocate(sizeof(DtorRecord), alignof(DtorRecord)));
+            T* obj = ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            // Registered only after construction succeeded
+            rec->destroy = [](void* p) noexcept { static_cast<T*>(p)->~T(); };
+            rec->object = obj;
+            rec->prev = dtors_;
+            dtors_ = rec;
+            ++pending_;
+            return obj;
+        }
+    }
+
+    // Handle-owned object, destroyed when the handle drops
+    template<typename T, typename... Args>
+    arena_ptr<T> make(Args&&... args) {
+        T* obj = ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        arena_deleter d;
+#ifndef NDEBUG
+        d.arena = this;
+        ++handles_;
+#endif
+        return arena_ptr<T>(obj, d);
+    }
+
+    // Runs recorded destructors (newest first) and rewinds to the first chunk
+    void reset() noexcept {
+#ifndef NDEBUG
+        assert(handles_ == 0 && "arena_ptr still alive at monotonic_arena::reset()");
+#endif
+        for (DtorRecord* r = dtors_; r; r = r->prev) r->destroy(r->object);
+        dtors_ = nullptr;
+        pending_ = 0;
+        current_ = 0;
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    std::size_t bytesUsed() const noexcept { return used_; }
+    std::size_t chunkCount() const noexcept { return chunks_.size(); }
+    std::size_t pendingDestructors() const noexcept { return pending_; }
+
+private:
+    friend struct arena_deleter;
+
+    struct Chunk {
+        char* data;
+        std::size_t size;
+    };
+
+    struct DtorRecord {
+        void (*destroy)(void*) noexcept;
+        void* object;
+        DtorRecord* prev;
+    };
+
+    // Appends a chunk big enough for `atLeast` bytes and makes it current
+    void addChunk(std::size_t atLeast) {
+        const std::size_t size = atLeast > chunkSize_ ? atLeast : chunkSize_;
+        chunks_.push_back({static_cast<char*>(::operator new(size)), size});
+        current_ = chunks_.size() - 1;
+        offset_ = 0;
+    }
+
+    std::size_t chunkSize_;
+    std::vector<Chunk> chunks_;
+    std::size_t current_ = 0;
+    std::size_t offset_ = 0; // within chunks_[current_]
+    std::size_t used_ = 0;
+    DtorRecord* dtors_ = nullptr;
+    std::size_t pending_ = 0;
+#ifndef NDEBUG
+    std::size_t handles_ = 0;
+#endif
+};
+
+template<typename T>
+void arena_deleter::operator()(T* p) const noexcept {
+    p->~T();
+#ifndef NDEBUG
+    if (arena) --arena->handles_;
+#endif
+}
+
+} // namespace smartptrs
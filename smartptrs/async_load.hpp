@@ -0,0 +1,326 @@
+/*******************************************************************************
+ * async_load.hpp
+ * Handle to a shared_ptr<T> being loaded elsewhere: co_await it (C++20) or
+ * use it like a future (C++17)
+ *
+ * ResourceCache::getOrCreateAsync returns a load_task<T>. The load itself
+ * runs on a thread_pool and is shared by everyone asking for the same key;
+ * each requester holds only its own load_task:
+ *
+ *   // C++20: inside any coroutine (smartptrs::task below, or your own)
+ *   std::shared_ptr<Texture> t = co_await cache.getOrCreateAsync("tex", pool, load);
+ *
+ *   // C++17: future-style
+ *   auto pending = cache.getOrCreateAsync("tex", pool, load);
+ *   ...                                      // do other work
+ *   std::shared_ptr<Texture> t = pending.get(); // waits; rethrows load errors
+ *
+ * DETAILS:
+ *   - a requester that cancels (cancel(), or simply destroys its
+ *     load_task) is dropped from the load: the result is never handed to
+ *     it, so abandoned requests keep nothing alive. The load still finishes
+ *     for the others and the cache records it (weakly, as always)
+ *   - an awaiting coroutine is resumed on the thread that finished the
+ *     load (a pool worker); if the load was already done it continues
+ *     without suspending
+ *   - get() moves the result out; the load_task is empty afterwards
+ *   - do not cancel a load_task that a coroutine is suspended on: destroy
+ *     that coroutine instead
+ *
+ * task<T> (C++20 only) is a minimal lazy coroutine type for composing
+ * loads; sync_wait(task) runs one to completion on the calling thread.
+ ******************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <optional>
+#define SMARTPTRS_HAS_COROUTINES 1
+#else
+#define SMARTPTRS_HAS_COROUTINES 0
+#endif
+
+namespace smartptrs {
+
+namespace detail {
+
+// One requester's view of a shared load; the loader holds it weakly
+template<typename T>
+class load_request {
+public:
+    // Called once by whoever finished the load; ignored after cancel()
+    void complete(const std::shared_ptr<T>& value, std::exception_ptr error) noexcept {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (state_ != state::waiting) return;
+        value_ = value;
+        error_ = std::move(error);
+        state_ = state::ready;
+#if SMARTPTRS_HAS_COROUTINES
+        std::coroutine_handle<> awaiting = std::exchange(awaiting_, nullptr);
+#endif
+        lock.unlock();
+        readyCv_.notify_all();
+#if SMARTPTRS_HAS_COROUTINES
+        if (awaiting) awaiting.resume();
+#endif
+    }
+
+    void cancel() noexcept {
+        std::shared_ptr<T> drop; // released outside the lock
+        std::lock_guard<std::mutex> lock(mutex_);
+        state_ = state::cancelled;
+        drop = std::move(value_);
+#if SMARTPTRS_HAS_COROUTINES
+        awaiting_ = nullptr;
+#endif
+    }
+
+    bool ready() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return state_ == state::ready;
+    }
+
+    void wait() const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        readyCv_.wait(lock, [this] { return state_ != state::waiting; });
+    }
+
+    template<typename Rep, typename Period>
+    bool waitFor(const std::chrono::duration<Rep, Period>& timeout) const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return readyCv_.wait_for(lock, timeout, [this] { return state_ != state::waiting; });
+    }
+
+    // Waits, then moves the result out or rethrows the load's exception
+    std::shared_ptr<T> take() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        readyCv_.wait(lock, [this] { return state_ != state::waiting; });
+        if (state_ == state::cancelled) throw std::logic_error("load_task: cancelled");
+        if (error_) std::rethrow_exception(error_);
+        return std::move(value_);
+    }
+
+#if SMARTPTRS_HAS_COROUTINES
+    // False if already complete (the coroutine then continues at once)
+    bool suspend(std::coroutine_handle<> awaiting) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != state::waiting) return false;
+        awaiting_ = awaiting;
+        return true;
+    }
+#endif
+
+private:
+    enum class state : unsigned char { waiting, ready, cancelled };
+
+    mutable std::mutex mutex_;
+    mutable std::condition_variable readyCv_;
+    state state_ = state::waiting;
+    std::shared_ptr<T> value_;
+    std::exception_ptr error_;
+#if SMARTPTRS_HAS_COROUTINES
+    std::coroutine_handle<> awaiting_;
+#endif
+};
+
+} // namespace detail
+
+template<typename T>
+class load_task {
+public:
+    load_task() noexcept = default;
+
+    // Already loaded (a cache hit): no shared state, no allocation
+    explicit load_task(std::shared_ptr<T> value) noexcept : value_(std::move(value)), done_(true) {}
+    explicit load_task(std::shared_ptr<detail::load_request<T>> request) noexcept
+        : request_(std::move(request)) {}
+
+    load_task(load_task&& other) noexcept
+        : value_(std::move(other.value_)), request_(std::move(other.request_)),
+          done_(std::exchange(other.done_, false)) {}
+    load_task& operator=(load_task&& other) noexcept {
+        if (this != &other) {
+            cancel();
+            value_ = std::move(other.value_);
+            request_ = std::move(other.request_);
+            done_ = std::exchange(other.done_, false);
+        }
+        return *this;
+    }
+    load_task(const load_task&) = delete;
+    load_task& operator=(const load_task&) = delete;
+
+    ~load_task() { cancel(); }
+
+    // False once get() has been called, after cancel(), or if default-built
+    bool valid() const noexcept { return done_ || request_; }
+    bool ready() const { return done_ || (request_ && request_->ready()); }
+
+    void wait() const {
+        if (request_) request_->wait();
+    }
+    template<typename Rep, typename Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+        return !request_ || request_->waitFor(timeout);
+    }
+
+    // Waits for the load; returns the object or rethrows the factory's exception
+    std::shared_ptr<T> get() {
+        if (done_) {
+            done_ = false;
+            return std::move(value_);
+        }
+        if (!request_) throw std::logic_error("load_task: no result (empty, taken or cancelled)");
+        auto request = std::move(request_);
+        return request->take();
+    }
+
+    // Leaves the load; the result is never delivered here
+    void cancel() noexcept {
+        if (request_) std::exchange(request_, nullptr)->cancel();
+        value_.reset();
+        done_ = false;
+    }
+
+#if SMARTPTRS_HAS_COROUTINES
+    bool await_ready() const { return ready(); }
+    bool await_suspend(std::coroutine_handle<> awaiting) { return request_ && request_->suspend(awaiting); }
+    std::shared_ptr<T> await_resume() { return get(); }
+#endif
+
+private:
+    std::shared_ptr<T> value_;
+    std::shared_ptr<detail::load_request<T>> request_;
+    bool done_ = false;
+};
+
+#if SMARTPTRS_HAS_COROUTINES
+
+// Lazy coroutine: starts when awaited, resumes its awaiter when it returns
+template<typename T>
+class task {
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+
+        task get_return_object() noexcept {
+            return task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct resume_continuation {
+                bool await_ready() const noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> self) noexcept {
+                    std::coroutine_handle<> next = self.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+            return resume_continuation{};
+        }
+        template<typename U>
+        void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() {
+        promise_type& p = handle_.promise();
+        if (p.error) std::rethrow_exception(p.error);
+        return std::move(*p.value);
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> h) noexcept : handle_(h) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+// Eagerly started driver for sync_wait; signals when its body is done
+struct sync_wait_driver {
+    struct promise_type {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+
+        sync_wait_driver get_return_object() noexcept {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct signal {
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> self) noexcept {
+                    promise_type& p = self.promise();
+                    std::lock_guard<std::mutex> lock(p.mutex);
+                    p.done = true;
+                    p.cv.notify_all();
+                }
+                void await_resume() const noexcept {}
+            };
+            return signal{};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {} // the body below catches everything
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+} // namespace detail
+
+// Runs t on the calling thread until its first suspension and waits for
+// the rest (which may finish on a pool worker); returns its result
+template<typename T>
+T sync_wait(task<T> t) {
+    std::optional<T> result;
+    std::exception_ptr error;
+    auto body = [&]() -> detail::sync_wait_driver {
+        try {
+            result.emplace(co_await std::move(t));
+        } catch (...) {
+            error = std::current_exception();
+        }
+    };
+    detail::sync_wait_driver driver = body();
+    {
+        auto& p = driver.handle.promise();
+        std::unique_lock<std::mutex> lock(p.mutex);
+        p.cv.wait(lock, [&] { return p.done; });
+    }
+    driver.handle.destroy();
+    if (error) std::rethrow_exception(error);
+    return std::move(*result);
+}
+
+#endif // SMARTPTRS_HAS_COROUTINES
+
+} // namespace smartptrs
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * atomic_slot.hpp
+ * Hot-swappable shared_ptr for configuration-style publication: many
+ * readers, an occasional writer
+ *
+ *   smartptrs::atomic_shared_slot<Config> config(std::make_shared<Config>());
+ *   config.store(std::make_shared<Config>(newValues));      // writer
+ *   std::shared_ptr<Config> c = config.load();               // owning snapshot
+ *   config.read([](const std::shared_ptr<Config>& c) { ... }); // borrowed
+ *
+ * BACKENDS (second template argument):
+ *   - std_atomic_slot  std::atomic<std::shared_ptr<T>> (C++20 library
+ *                      support, __cpp_lib_atomic_shared_ptr). The default
+ *                      where available.
+ *   - epoch_slot       C++17 fallback. The shared_ptr sits in a node
+ *                      published through an atomic pointer; store() swaps
+ *                      nodes and retires the old one with epoch_reclaimer.
+ *                      load() is an epoch pin plus one count increment;
+ *                      read() is only the pin - readers make no shared
+ *                      writes at all.
+ *
+ * read(fn) calls fn(const std::shared_ptr<T>&); the reference is valid only
+ * during fn (copy it to keep the object). With epoch_slot, fn runs pinned,
+ * so keep it short and don't block in it.
+ ******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "epoch.hpp"
+
+namespace smartptrs {
+
+struct epoch_slot {};
+struct std_atomic_slot {};
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+using default_slot_backend = std_atomic_slot;
+#else
+using default_slot_backend = epoch_slot;
+#endif
+
+template<typename T, typename Backend = default_slot_backend>
+class atomic_shared_slot;
+
+template<typename T>
+class atomic_shared_slot<T, epoch_slot> {
+public:
+    explicit atomic_shared_slot(std::shared_ptr<T> initial = nullptr)
+        : node_(new Node{std::move(initial)}) {}
+    atomic_shared_slot(const atomic_shared_slot&) = delete;
+    atomic_shared_slot& operator=(const atomic_shared_slot&) = delete;
+
+    // No reader may still be inside load()/read()
+    ~atomic_shared_slot() { delete node_.load(std::memory_order_relaxed); }
+
+    std::shared_ptr<T> load() const {
+        epoch_reclaimer::guard pin;
+        return node_.load(std::memory_order_acquire)->value;
+    }
+
+    template<typename Fn>
+    decltype(auto) read(Fn&& fn) const {
+        epoch_reclaimer::guard pin;
+        return std::forward<Fn>(fn)(std::as_const(node_.load(std::memory_order_acquire)->value));
+    }
+
+    void store(std::shared_ptr<T> desired) { exchange(std::move(desired)); }
+
+    std::shared_ptr<T> exchange(std::shared_ptr<T> desired) {
+        Node* fresh = new Node{std::move(desired)};
+        Node* old = node_.exchange(fresh, std::memory_order_acq_rel);
+        // Readers may still be copying old->value; hand back a copy and
+        // let the node die with the epoch
+        std::shared_ptr<T> previous = old->value;
+        epoch_reclaimer::retire(old);
+        return previous;
+    }
+
+private:
+    struct Node {
+        std::shared_ptr<T> value; // never modified once published
+    };
+
+    std::atomic<Node*> node_;
+};
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+template<typename T>
+class atomic_shared_slot<T, std_atomic_slot> {
+public:
+    explicit atomic_shared_slot(std::shared_ptr<T> initial = nullptr) : value_(std::move(initial)) {}
+    atomic_shared_slot(const atomic_shared_slot&) = delete;
+    atomic_shared_slot& operator=(const atomic_shared_slot&) = delete;
+
+    std::shared_ptr<T> load() const { return value_.load(std::memory_order_acquire); }
+
+    template<typename Fn>
+    decltype(auto) read(Fn&& fn) const {
+        const std::shared_ptr<T> snapshot = load();
+        return std::forward<Fn>(fn)(snapshot);
+    }
+
+    void store(std::shared_ptr<T> desired) { value_.store(std::move(desired), std::memory_order_release); }
+
+    std::shared_ptr<T> exchange(std::shared_ptr<T> desired) {
+        return value_.exchange(std::move(desired), std::memory_order_acq_rel);
+    }
+
+private:
+    std::atomic<std::shared_ptr<T>> value_;
+};
+#endif
+
+} // namespace smartptrs
@@ -0,0 +1,276 @@
+/*******************************************************************************
+ * batch_make.hpp
+ * Bulk factories: one allocation for many objects
+ *
+ *   auto arr = smartptrs::make_shared_array<Widget>(n, Widget(1));  // shared_ptr<Widget[]>
+ *   auto buf = smartptrs::make_unique_for_overwrite<char[]>(4096);  // not zeroed
+ *   std::vector<std::shared_ptr<Widget>> ws =
+ *       smartptrs::make_shared_batch<Widget>(n, 7, "batch");       // n owners, 1 block
+ *
+ * FACTORIES:
+ *   - make_shared_array<T>(n [, init])   C++17 backport of C++20
+ *     make_shared<T[]>(n): the elements (value-initialized, or copies of
+ *     init) and the control block share one allocation, unlike
+ *     shared_ptr<T[]>(new T[n]) which allocates both separately
+ *   - make_shared_array_for_overwrite<T>(n)   the same, default-initialized
+ *   - make_unique_for_overwrite<T>() / <T[]>(n)   C++20 backports: new T /
+ *     new T[n] without value-initialization (no zeroing of ints, buffers)
+ *   - make_shared_batch<T>(n, args...)   n independent shared_ptr<T>, each
+ *     constructed from args (copied, not forwarded: every object gets
+ *     them), with control blocks + objects carved from one slab
+ *
+ * DETAILS:
+ *   - make_shared_batch objects are individually owned: each one's
+ *     destructor runs when its own last shared_ptr goes, and weak_ptrs work
+ *     per object. The slab is freed once all n control blocks are freed (a
+ *     long-lived survivor, or its weak_ptrs, keep the whole slab alive)
+ *   - each batch slot carries a one-word back-pointer to its slab, so
+ *     control blocks can be freed on any thread without allocator state
+ *   - if a constructor throws, the objects built so far are destroyed and
+ *     all memory is released before the exception propagates
+ *   - a count whose block size would overflow std::size_t throws
+ *     std::bad_array_new_length, as new T[n] does
+ ******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace smartptrs {
+
+#if defined(__cpp_lib_smart_ptr_for_overwrite)
+using std::make_unique_for_overwrite;
+#else
+template<typename T>
+std::enable_if_t<!std::is_array_v<T>, std::unique_ptr<T>> make_unique_for_overwrite() {
+    return std::unique_ptr<T>(new T);
+}
+
+template<typename T>
+std::enable_if_t<std::is_array_v<T> && std::extent_v<T> == 0, std::unique_ptr<T>>
+make_unique_for_overwrite(std::size_t n) {
+    return std::unique_ptr<T>(new std::remove_extent_t<T>[n]);
+}
+#endif
+
+namespace detail {
+
+constexpr std::size_t roundUp(std::size_t n, std::size_t align) noexcept {
+    return (n + align - 1) / align * align;
+}
+
+// One raw block: [control block reserve][T x n]
+template<typename T>
+struct array_block {
+    static constexpr std::size_t kAlign =
+        alignof(T) > alignof(std::max_align_t) ? alignof(T) : alignof(std::max_align_t);
+    static constexpr std::size_t kControlReserve = roundUp(64, kAlign);
+
+    static void* allocate(std::size_t n) {
+        if (n > (SIZE_MAX - kControlReserve) / sizeof(T)) throw std::bad_array_new_length();
+        return ::operator new(kControlReserve + n * sizeof(T), std::align_val_t(kAlign));
+    }
+    static void deallocate(void* block) noexcept { ::operator delete(block, std::align_val_t(kAlign)); }
+    static T* elements(void* block) noexcept {
+        return reinterpret_cast<T*>(static_cast<char*>(block) + kControlReserve);
+    }
+};
+
+// Destroys the n elements newest first; the memory goes with the control block
+template<typename T>
+struct array_block_deleter {
+    std::size_t n;
+    void operator()(T* p) const noexcept {
+        for (std::size_t i = n; i > 0; --i) p[i - 1].~T();
+    }
+};
+
+// Serves shared_ptr's control block from the block's reserved head, and
+// frees the block when the control block is freed
+template<typename U, typename T>
+struct array_block_allocator {
+    using value_type = U;
+    void* block;
+
+    explicit array_block_allocator(void* b) noexcept : block(b) {}
+    template<typename V>
+    array_block_allocator(const array_block_allocator<V, T>& other) noexcept : block(other.block) {}
+    template<typename V>
+    struct rebind { using other = array_block_allocator<V, T>; };
+
+    U* allocate(std::size_t k) {
+        if (fitsHead(k)) return static_cast<U*>(block);
+        return static_cast<U*>(::operator new(k * sizeof(U), std::align_val_t(alignof(U))));
+    }
+
+    void deallocate(U* p, std::size_t k) noexcept {
+        if (!fitsHead(k)) ::operator delete(p, std::align_val_t(alignof(U)));
+        array_block<T>::deallocate(block);
+    }
+
+    static constexpr bool fitsHead(std::size_t k) noexcept {
+        return k * sizeof(U) <= array_block<T>::kControlReserve && alignof(U) <= array_block<T>::kAlign;
+    }
+
+    template<typename V>
+    bool operator==(const array_block_allocator<V, T>& o) const noexcept { return block == o.block; }
+    template<typename V>
+    bool operator!=(const array_block_allocator<V, T>& o) const noexcept { return block != o.block; }
+};
+
+template<typename T, typename Construct>
+std::shared_ptr<T[]> makeSharedArray(std::size_t n, Construct&& construct) {
+    void* block = array_block<T>::allocate(n);
+    T* elements = array_block<T>::elements(block);
+    std::size_t built = 0;
+    try {
+        for (; built < n; ++built) construct(static_cast<void*>(elements + built));
+    } catch (...) {
+        array_block_deleter<T>{built}(elements);
+        array_block<T>::deallocate(block);
+        throw;
+    }
+    try {
+        // On failure shared_ptr runs the deleter itself; the block was not
+        // handed to a control block, so free it here
+        return std::shared_ptr<T[]>(elements, array_block_deleter<T>{n},
+                                    array_block_allocator<T, T>(block));
+    } catch (...) {
+        array_block<T>::deallocate(block);
+        throw;
+    }
+}
+
+// Slab for make_shared_batch: a header, then n slots of
+// [slab back-pointer][control block with the object]
+struct batch_slab {
+    std::atomic<std::size_t> outstanding; // slots not yet freed
+    std::size_t align;
+
+    static batch_slab* create(std::size_t slots, std::size_t stride, std::size_t align) {
+        if (slots > (SIZE_MAX - headerSize(align)) / stride) throw std::bad_array_new_length();
+        void* raw = ::operator new(headerSize(align) + slots * stride, std::align_val_t(align));
+        return ::new (raw) batch_slab{{slots}, align};
+    }
+
+    static constexpr std::size_t headerSize(std::size_t align) noexcept {
+        return roundUp(sizeof(batch_slab), align);
+    }
+
+    char* slot(std::size_t i, std::size_t stride) noexcept {
+        return reinterpret_cast<char*>(this) + headerSize(align) + i * stride;
+    }
+
+    // Drops `count` slots; the last one frees the slab
+    void release(std::size_t count) noexcept {
+        if (outstanding.fetch_sub(count, std::memory_order_acq_rel) == count) {
+            const std::size_t a = align;
+            this->~batch_slab();
+            ::operator delete(static_cast<void*>(this), std::align_val_t(a));
+        }
+    }
+};
+
+// State of one make_shared_batch call; only allocate() touches it
+struct batch_builder {
+    std::size_t n;
+    std::size_t used = 0;
+    std::size_t stride = 0;
+    batch_slab* slab = nullptr;
+};
+
+template<typename U>
+struct batch_allocator {
+    using value_type = U;
+    batch_builder* builder; // dangling after the batch is built; only allocate() reads it
+
+    explicit batch_allocator(batch_builder* b) noexcept : builder(b) {}
+    template<typename V>
+    batch_allocator(const batch_allocator<V>& other) noexcept : builder(other.builder) {}
+
+    static constexpr std::size_t kAlign = alignof(U) > alignof(void*) ? alignof(U) : alignof(void*);
+    static constexpr std::size_t kPrefix = roundUp(sizeof(void*), kAlign);
+
+    U* allocate(std::size_t k) {
+        batch_builder& b = *builder;
+        if (k == 1 && !b.slab && b.used == 0) {
+            b.stride = kPrefix + roundUp(sizeof(U), kAlign);
+            b.slab = batch_slab::create(b.n, b.stride, kAlign);
+        }
+        char* mem;
+        if (k == 1 && b.slab && b.stride == kPrefix + roundUp(sizeof(U), kAlign) && b.used < b.n &&
+            b.slab->align == kAlign) {
+            mem = b.slab->slot(b.used++, b.stride) + kPrefix;
+            backPointer(mem) = b.slab;
+        } else {
+            // Unexpected request shape: a standalone block, null back-pointer
+            char* raw = static_cast<char*>(::operator new(kPrefix + k * sizeof(U), std::align_val_t(kAlign)));
+            mem = raw + kPrefix;
+            backPointer(mem) = nullptr;
+        }
+        return reinterpret_cast<U*>(mem);
+    }
+
+    void deallocate(U* p, std::size_t) noexcept {
+        char* mem = reinterpret_cast<char*>(p);
+        if (batch_slab* slab = backPointer(mem)) slab->release(1);
+        else ::operator delete(mem - kPrefix, std::align_val_t(kAlign));
+    }
+
+    static batch_slab*& backPointer(char* mem) noexcept {
+        return *reinterpret_cast<batch_slab**>(mem - sizeof(batch_slab*));
+    }
+
+    template<typename V>
+    bool operator==(const batch_allocator<V>&) const noexcept { return true; }
+    template<typename V>
+    bool operator!=(const batch_allocator<V>&) const noexcept { return false; }
+};
+
+} // namespace detail
+
+// shared_ptr<T[]> to n value-initialized elements; one allocation
+template<typename T>
+std::shared_ptr<T[]> make_shared_array(std::size_t n) {
+    return detail::makeSharedArray<T>(n, [](void* p) { ::new (p) T(); });
+}
+
+// shared_ptr<T[]> to n copies of init; one allocation
+template<typename T>
+std::shared_ptr<T[]> make_shared_array(std::size_t n, const T& init) {
+    return detail::makeSharedArray<T>(n, [&init](void* p) { ::new (p) T(init); });
+}
+
+// shared_ptr<T[]> to n default-initialized elements; one allocation
+template<typename T>
+std::shared_ptr<T[]> make_shared_array_for_overwrite(std::size_t n) {
+    return detail::makeSharedArray<T>(n, [](void* p) { ::new (p) T; });
+}
+
+// n individually owned shared_ptr<T>(T(args...)) from one slab
+template<typename T, typename... Args>
+std::vector<std::shared_ptr<T>> make_shared_batch(std::size_t n, const Args&... args) {
+    std::vector<std::shared_ptr<T>> out;
+    out.reserve(n);
+    if (n == 0) return out;
+    detail::batch_builder builder{n};
+    try {
+        for (std::size_t i = 0; i < n; ++i) {
+            out.push_back(std::allocate_shared<T>(detail::batch_allocator<T>(&builder), args...));
+        }
+    } catch (...) {
+        out.clear(); // frees their slots; unused slots still pin the slab
+        if (builder.slab && builder.used < n) builder.slab->release(n - builder.used);
+        throw;
+    }
+    if (builder.slab && builder.used < n) builder.slab->release(n - builder.used);
+    return out;
+}
+
+} // namespace smartptrs
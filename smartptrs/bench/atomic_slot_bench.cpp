@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * atomic_slot_bench.cpp
+ * Configuration publication: 1 writer, N readers
+ *
+ * A writer thread keeps replacing a shared Config while N reader threads
+ * read one field of the current one. Read paths compared:
+ *   - mutex + shared_ptr copy
+ *   - std::atomic_load(&shared_ptr) (the C++11 free functions)
+ *   - atomic_shared_slot<epoch_slot>::load()  (pin + count increment)
+ *   - atomic_shared_slot<epoch_slot>::read()  (pin only, no shared writes)
+ *   - atomic_shared_slot<std_atomic_slot>::load(), when built as C++20
+ *
+ * ns/op is per read per reader thread; the writer's stores are not timed.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread atomic_slot_bench.cpp -o atomic_slot_bench
+ *        (add -std=c++20 for the std::atomic<shared_ptr> row)
+ * Run:   ./atomic_slot_bench [reader threads, default 1,2,4,8]
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../atomic_slot.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t kReads = 1'000'000;
+
+struct Config {
+    int version;
+    int limits[15];
+    explicit Config(int v) : version(v), limits{} {}
+};
+
+// Runs `readers` threads of read(), while one writer calls write(version)
+template<typename Read, typename Write>
+void withWriter(const char* name, size_t readers, Read&& read, Write&& write) {
+    atomic<bool> stop{false};
+    thread writer([&] {
+        for (int v = 1; !stop.load(memory_order_relaxed); ++v) {
+            write(v);
+            this_thread::yield();
+        }
+    });
+    bench::runThreads(name, readers, kReads, [&](size_t, size_t) { bench::doNotOptimize(read()); });
+    stop.store(true);
+    writer.join();
+    smartptrs::epoch_reclaimer::collect();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const auto threads = bench::threadCounts(argc, argv, 1);
+
+    mutex lock;
+    shared_ptr<Config> guarded = make_shared<Config>(0);
+    shared_ptr<Config> freeFunctions = make_shared<Config>(0);
+    smartptrs::atomic_shared_slot<Config, smartptrs::epoch_slot> epochSlot(make_shared<Config>(0));
+#if defined(__cpp_lib_atomic_shared_ptr)
+    smartptrs::atomic_shared_slot<Config, smartptrs::std_atomic_slot> stdSlot(make_shared<Config>(0));
+#endif
+
+    for (size_t n : threads) {
+        char title[64];
+        snprintf(title, sizeof title, "1 writer, %zu reader(s)", n);
+        bench::printHeader(title);
+
+        withWriter("mutex + shared_ptr copy", n,
+            [&] {
+                shared_ptr<Config> c;
+                {
+                    lock_guard<mutex> g(lock);
+                    c = guarded;
+                }
+                return c->version;
+            },
+            [&](int v) {
+                auto fresh = make_shared<Config>(v);
+                lock_guard<mutex> g(lock);
+                guarded.swap(fresh);
+            });
+
+        withWriter("std::atomic_load(shared_ptr*)", n,
+            [&] { return atomic_load(&freeFunctions)->version; },
+            [&](int v) { atomic_store(&freeFunctions, make_shared<Config>(v)); });
+
+        withWriter("slot<epoch_slot>::load", n,
+            [&] { return epochSlot.load()->version; },
+            [&](int v) { epochSlot.store(make_shared<Config>(v)); });
+
+        withWriter("slot<epoch_slot>::read (borrowed)", n,
+            [&] { return epochSlot.read([](const shared_ptr<Config>& c) { return c->version; }); },
+            [&](int v) { epochSlot.store(make_shared<Config>(v)); });
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+        withWriter("slot<std_atomic_slot>::load", n,
+            [&] { return stdSlot.load()->version; },
+            [&](int v) { stdSlot.store(make_shared<Config>(v)); });
+#endif
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*******************************************************************************
+ * batch_make_bench.cpp
+ * Bulk creation: per-object factories vs the batch_make.hpp bulk factories
+ *
+ * ns/op and allocs/op are per object; the number in parentheses after each
+ * name is allocations per whole set. Each set is built and then dropped:
+ *   - 10^6 shared Widgets: make_shared in a loop vs make_shared_batch
+ *     (both into a reserved vector<shared_ptr>)
+ *   - 4096-element arrays of a 16-byte POD: shared_ptr<T[]>(new T[n]()) vs
+ *     make_shared_array / make_shared_array_for_overwrite, and
+ *     make_unique<T[]> vs make_unique_for_overwrite<T[]>
+ *
+ * Build: g++ -std=c++17 -O2 batch_make_bench.cpp -o batch_make_bench
+ * Run:   ./batch_make_bench [widgets, default 1000000]
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../batch_make.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace std;
+using bench::QuietWidget;
+
+namespace {
+
+struct Particle {
+    float x, y, z;
+    int id;
+};
+
+constexpr size_t kArray = 4096;
+
+// Runs fn() reps times (after one warm-up) and prints the cost per object;
+// the label gets the allocations per whole set, which per-object rounds away
+template<typename Fn>
+void perObject(const char* name, size_t objects, size_t reps, Fn&& fn) {
+    fn();
+    const uint64_t allocsBefore = bench::allocationCount();
+    const auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < reps; ++r) fn();
+    const double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    const double allocs = double(bench::allocationCount() - allocsBefore);
+    const double total = double(objects) * double(reps);
+    char label[96];
+    snprintf(label, sizeof label, "%s (%.0f)", name, allocs / double(reps));
+    bench::printRow(label, {ns / total, allocs / total});
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t n = argc > 1 ? size_t(strtoull(argv[1], nullptr, 10)) : 1'000'000;
+    printf("batch_make benchmarks (%zu widgets, %zu-element arrays)\n", n, kArray);
+
+    bench::printHeader("n shared_ptr<Widget>: create, then drop all");
+    perObject("make_shared loop", n, 5, [&] {
+        vector<shared_ptr<QuietWidget>> ws;
+        ws.reserve(n);
+        for (size_t i = 0; i < n; ++i) ws.push_back(make_shared<QuietWidget>(7));
+        bench::doNotOptimize(ws.back()->id);
+    });
+    perObject("make_shared_batch", n, 5, [&] {
+        auto ws = smartptrs::make_shared_batch<QuietWidget>(n, 7);
+        bench::doNotOptimize(ws.back()->id);
+    });
+
+    const size_t reps = 2000;
+    bench::printHeader("shared_ptr<Particle[]> of 4096");
+    perObject("shared_ptr<T[]>(new T[n]())", kArray, reps, [] {
+        shared_ptr<Particle[]> a(new Particle[kArray]());
+        bench::doNotOptimize(a[1].id);
+    });
+    perObject("make_shared_array", kArray, reps, [] {
+        auto a = smartptrs::make_shared_array<Particle>(kArray);
+        bench::doNotOptimize(a[1].id);
+    });
+    perObject("make_shared_array_for_overwrite", kArray, reps, [] {
+        auto a = smartptrs::make_shared_array_for_overwrite<Particle>(kArray);
+        a[1].id = 1;
+        bench::doNotOptimize(a[1].id);
+    });
+
+    bench::printHeader("unique_ptr<Particle[]> of 4096");
+    perObject("make_unique<T[]>", kArray, reps, [] {
+        auto a = make_unique<Particle[]>(kArray);
+        bench::doNotOptimize(a[1].id);
+    });
+    perObject("make_unique_for_overwrite<T[]>", kArray, reps, [] {
+        auto a = smartptrs::make_unique_for_overwrite<Particle[]>(kArray);
+        a[1].id = 1;
+        bench::doNotOptimize(a[1].id);
+    });
+    return 0;
+}
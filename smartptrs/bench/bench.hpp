@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * bench.hpp
+ * Minimal microbenchmark harness shared by the programs in bench/
+ *
+ * - run(name, iterations, fn) times fn(i) and prints ns/op and allocs/op
+ * - runThreads(name, threads, iterations, fn) runs fn(thread, i) on several
+ *   threads released together; ns/op is wall time per op per thread
+ * - threadCounts(argc, argv) parses "1,2,4,8"-style thread lists
+ * - Heap allocations are counted by replacing global operator new, so include
+ *   this header from exactly one translation unit per benchmark binary
+ * - doNotOptimize(v) keeps the optimizer from discarding a computed value
+ * - QuietWidget is the tutorial Widget instantiated with no_trace
+ *
+ * Build benchmarks with optimizations and -pthread (libstdc++ only uses
+ * atomic ref-counting once the program is multi-threaded):
+ *   g++ -std=c++17 -O2 -pthread resource_cache_bench.cpp -o resource_cache_bench
+ ******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../demo_types.hpp"
+
+namespace bench {
+
+// Per-thread count of operator new calls (thread_local: counting must not
+// itself become a contended shared write)
+inline std::uint64_t& allocationCount() noexcept {
+    static thread_local std::uint64_t count = 0;
+    return count;
+}
+
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// The tutorial Widget with its trace calls compiled away
+using QuietWidget = smartptrs::BasicWidget<smartptrs::no_trace>;
+
+struct Result {
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+inline void printHeader(const char* title) {
+    std::printf("\n%s\n%-44s %12s %12s\n", title, "benchmark", "ns/op", "allocs/op");
+}
+
+inline void printRow(const char* name, const Result& r) {
+    std::printf("%-44s %12.2f %12.3f\n", name, r.nsPerOp, r.allocsPerOp);
+}
+
+// Times iterations calls of fn(i) after a short warm-up and prints one row
+template<typename Fn>
+Result run(const char* name, std::size_t iterations, Fn&& fn) {
+    for (std::size_t i = 0; i < iterations / 10 + 1; ++i) fn(i);
+
+    const std::uint64_t allocsBefore = allocationCount();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) fn(i);
+    const auto stop = std::chrono::steady_clock::now();
+    const std::uint64_t allocs = allocationCount() - allocsBefore;
+
+    const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    Result r{ns / double(iterations), double(allocs) / double(iterations)};
+    printRow(name, r);
+    return r;
+}
+
+// Runs fn(t, i) for i in [0, iterations) on each of `threads` threads. All
+// threads warm up, wait at a start line, and are timed from the release to
+// the last one finishing. allocs/op counts every thread's allocations.
+template<typename Fn>
+Result runThreads(const char* name, std::size_t threads, std::size_t iterations, Fn&& fn) {
+    std::atomic<std::size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<std::uint64_t> allocs{0};
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (std::size_t i = 0; i < iterations / 10 + 1; ++i) fn(t, i);
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            const std::uint64_t before = allocationCount();
+            for (std::size_t i = 0; i < iterations; ++i) fn(t, i);
+            allocs.fetch_add(allocationCount() - before);
+        });
+    }
+    while (ready.load() != threads) std::this_thread::yield();
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    const auto stop = std::chrono::steady_clock::now();
+
+    const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    Result r{ns / double(iterations), double(allocs.load()) / double(iterations * threads)};
+    char label[96];
+    std::snprintf(label, sizeof label, "%s [%zu thr]", name, threads);
+    printRow(label, r);
+    return r;
+}
+
+// Thread counts from argv[index] ("1,2,4,8"), or `fallback`
+inline std::vector<std::size_t> threadCounts(int argc, char** argv, int index,
+                                             std::vector<std::size_t> fallback = {1, 2, 4, 8}) {
+    if (argc <= index) return fallback;
+    std::vector<std::size_t> counts;
+    for (const char* p = argv[index]; *p;) {
+        char* end = nullptr;
+        const unsigned long n = std::strtoul(p, &end, 10);
+        if (end == p) break;
+        if (n > 0) counts.push_back(n);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return counts.empty() ? fallback : counts;
+}
+
+} // namespace bench
+
+// Replacement allocation functions (one definition per program). GCC flags
+// free() of operator new's result once both are inlined; here it's correct.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t size) {
+    ++bench::allocationCount();
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    ++bench::allocationCount();
+    const std::size_t a = static_cast<std::size_t>(align);
+    if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
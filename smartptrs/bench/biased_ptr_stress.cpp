@@ -0,0 +1,107 @@
+/*******************************************************************************
+ * biased_ptr_stress.cpp
+ * biased_ptr owner-exit races: other threads drop the last references to
+ * objects whose owner thread is exiting, while new threads take over the
+ * exited owners' records
+ *
+ * Each round starts pairs of threads:
+ *   - the owner makes objects, copies each into a handoff (a biased copy),
+ *     drops its own reference and exits; the exit merges what it still owns
+ *   - the releaser waits for the handoff and drops it, optionally after
+ *     copying it once more, spinning a varying number of iterations so the
+ *     drop lands before, during or after the owner's exit merge
+ * and a few threads that make and drop objects of their own, so exited
+ * owners' records are reused while objects are still queued on them.
+ * After the round joins, every object must have been destroyed exactly
+ * once. Build with -fsanitize=address (or thread) to check the frees, not
+ * just the counts.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread biased_ptr_stress.cpp -o biased_ptr_stress
+ * Run:   ./biased_ptr_stress [rounds, default 2000]
+ ******************************************************************************/
+
+#include "../biased_ptr.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t kPairs = 4;
+constexpr size_t kObjects = 8; // per owner
+constexpr size_t kChurners = 2;
+
+atomic<long> created{0};
+atomic<long> destroyed{0};
+
+struct Counted {
+    Counted() { created.fetch_add(1, memory_order_relaxed); }
+    ~Counted() { destroyed.fetch_add(1, memory_order_relaxed); }
+};
+
+struct Handoff {
+    vector<smartptrs::biased_ptr<Counted>> objects;
+    atomic<bool> ready{false};
+};
+
+void spin(unsigned n) {
+    for (volatile unsigned i = 0; i < n; ++i) {}
+}
+
+void round(unsigned seed) {
+    vector<Handoff> handoffs(kPairs);
+    vector<thread> threads;
+    for (size_t p = 0; p < kPairs; ++p) {
+        Handoff& h = handoffs[p];
+        threads.emplace_back([&h] {
+            for (size_t i = 0; i < kObjects; ++i) {
+                auto w = smartptrs::make_biased<Counted>();
+                h.objects.push_back(w); // counted by this thread's bias
+            }                           // w dropped: the owner's count is 1 each
+            h.ready.store(true, memory_order_release);
+        });                             // exit merges the owned objects
+        const unsigned delay = (seed + unsigned(p) * 37) % 400;
+        const bool copyFirst = (seed + p) % 3 == 0;
+        threads.emplace_back([&h, delay, copyFirst] {
+            while (!h.ready.load(memory_order_acquire)) this_thread::yield();
+            spin(delay);
+            for (auto& object : h.objects) {
+                smartptrs::biased_ptr<Counted> extra;
+                if (copyFirst) extra = object; // counted atomically, dropped last
+                object.reset();
+            }
+        });
+    }
+    for (size_t c = 0; c < kChurners; ++c) {
+        threads.emplace_back([seed, c] {
+            spin((seed * 7 + unsigned(c) * 101) % 300);
+            for (size_t i = 0; i < kObjects; ++i) {
+                auto w = smartptrs::make_biased<Counted>();
+                auto copy = w;
+            }
+        });
+    }
+    for (thread& t : threads) t.join();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const unsigned rounds = argc > 1 ? unsigned(strtoul(argv[1], nullptr, 10)) : 2000;
+    for (unsigned r = 0; r < rounds; ++r) {
+        round(r);
+        const long live = created.load() - destroyed.load();
+        if (live != 0) {
+            printf("round %u: %ld object(s) not destroyed\n", r, live);
+            return 1;
+        }
+    }
+    printf("biased_ptr owner-exit stress: %u rounds, %ld objects created and destroyed\n", rounds,
+           created.load());
+    return 0;
+}
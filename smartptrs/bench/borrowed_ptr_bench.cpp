@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * borrowed_ptr_bench.cpp
+ * Ref-count traffic in a multi-threaded call chain: shared_ptr by value vs
+ * const shared_ptr& vs borrowed_ptr
+ *
+ * Every thread forwards the same Widget ("contended": one control block
+ * shared by all threads) through a chain of 4 non-inlined calls, then hands
+ * it to a task lambda that is built, run and dropped:
+ *   - by value: one atomic increment + decrement per call and per capture
+ *   - by const&: no count traffic, but the capture still copies
+ *   - borrowed_ptr: no count traffic anywhere, capture included
+ * A per-thread-object by-value row separates the contention cost from the
+ * cost of the atomics themselves.
+ *
+ * Build: g++ -std=c++17 -O2 -DNDEBUG -pthread borrowed_ptr_bench.cpp -o borrowed_ptr_bench
+ * Run:   ./borrowed_ptr_bench [threads, default 1,2,4,8]
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../borrowed_ptr.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace std;
+using bench::QuietWidget;
+using smartptrs::borrowed_ptr;
+
+namespace {
+
+constexpr size_t kIterations = 1'000'000;
+
+#ifdef NDEBUG
+static_assert(sizeof(borrowed_ptr<QuietWidget>) == sizeof(void*));
+#endif
+
+struct alignas(64) Local {
+    shared_ptr<QuietWidget> shared;
+};
+
+// Runs a task in place; noinline so the capture really is built and copied
+template<typename Task>
+__attribute__((noinline)) int runTask(Task task) {
+    return task();
+}
+
+__attribute__((noinline)) int byValue4(shared_ptr<QuietWidget> w) {
+    return runTask([w] { return w->id; });
+}
+__attribute__((noinline)) int byValue3(shared_ptr<QuietWidget> w) { return byValue4(w); }
+__attribute__((noinline)) int byValue2(shared_ptr<QuietWidget> w) { return byValue3(w); }
+__attribute__((noinline)) int byValue1(shared_ptr<QuietWidget> w) { return byValue2(w); }
+
+__attribute__((noinline)) int byRef4(const shared_ptr<QuietWidget>& w) {
+    return runTask([w] { return w->id; });
+}
+__attribute__((noinline)) int byRef3(const shared_ptr<QuietWidget>& w) { return byRef4(w); }
+__attribute__((noinline)) int byRef2(const shared_ptr<QuietWidget>& w) { return byRef3(w); }
+__attribute__((noinline)) int byRef1(const shared_ptr<QuietWidget>& w) { return byRef2(w); }
+
+__attribute__((noinline)) int borrowed4(borrowed_ptr<const QuietWidget> w) {
+    return runTask([w] { return w->id; });
+}
+__attribute__((noinline)) int borrowed3(borrowed_ptr<const QuietWidget> w) { return borrowed4(w); }
+__attribute__((noinline)) int borrowed2(borrowed_ptr<const QuietWidget> w) { return borrowed3(w); }
+__attribute__((noinline)) int borrowed1(borrowed_ptr<const QuietWidget> w) { return borrowed2(w); }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const vector<size_t> threads = bench::threadCounts(argc, argv, 1);
+    printf("borrowed_ptr benchmarks (%zu iterations per thread)\n", kIterations);
+#ifndef NDEBUG
+    printf("WARNING: built without NDEBUG; borrowed_ptr carries its debug owner check\n");
+#endif
+
+    auto common = make_shared<QuietWidget>(7);
+    bench::printHeader("4 calls + task capture, shared Widget");
+    for (size_t t : threads) {
+        vector<Local> locals(t);
+        for (size_t i = 0; i < t; ++i) locals[i].shared = make_shared<QuietWidget>(int(i));
+
+        bench::runThreads("by value, contended", t, kIterations, [&](size_t, size_t) {
+            bench::doNotOptimize(byValue1(common));
+        });
+        bench::runThreads("by value, per-thread object", t, kIterations, [&](size_t k, size_t) {
+            bench::doNotOptimize(byValue1(locals[k].shared));
+        });
+        bench::runThreads("by const&, contended", t, kIterations, [&](size_t, size_t) {
+            bench::doNotOptimize(byRef1(common));
+        });
+        bench::runThreads("borrowed_ptr, contended", t, kIterations, [&](size_t, size_t) {
+            bench::doNotOptimize(borrowed1(common));
+        });
+    }
+    return 0;
+}
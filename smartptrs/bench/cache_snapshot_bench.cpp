@@ -0,0 +1,169 @@
+/*******************************************************************************
+ * cache_snapshot_bench.cpp
+ * Cold start vs warm start of a ResourceCache: rebuilding every resource
+ * through its factory vs mapping a save_snapshot file and decoding lazily
+ *
+ * The factory stands in for a real load (file read + decode): it derives
+ * each texel through a few rounds of xorshift. Decoding a snapshot entry
+ * copies the saved texels. Rows show the best of several runs:
+ *   - startup: the work before the first request (none cold; open, mmap
+ *     and index validation warm) and its heap allocations, which do not
+ *     grow with the number of entries
+ *   - time to first hit: startup plus the first getOrCreate
+ *   - all keys: startup plus one getOrCreate per key
+ * The snapshot was just written, so it is read from the page cache; a cold
+ * disk adds the read of the touched pages to the warm rows.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread cache_snapshot_bench.cpp -o cache_snapshot_bench
+ * Run:   ./cache_snapshot_bench [snapshot path, default cache_snapshot_bench.snap]
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../cache_snapshot.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t kTextures = 1000;
+constexpr size_t kTexels = 4096;
+constexpr int kRuns = 5;
+
+struct Texture {
+    string name;
+    vector<uint8_t> texels;
+};
+
+shared_ptr<Texture> loadTexture(const string& name, size_t seed) {
+    auto t = make_shared<Texture>();
+    t->name = name;
+    t->texels.resize(kTexels);
+    uint64_t x = seed * 0x9E3779B97F4A7C15ull + 1;
+    for (uint8_t& texel : t->texels) {
+        for (int round = 0; round < 16; ++round) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+        }
+        texel = uint8_t(x);
+    }
+    return t;
+}
+
+shared_ptr<Texture> decodeTexture(string_view key, string_view bytes) {
+    auto t = make_shared<Texture>();
+    t->name = string(key);
+    t->texels.assign(bytes.begin(), bytes.end());
+    return t;
+}
+
+using Cache = smartptrs::ResourceCache<Texture>;
+
+struct Timings {
+    double startupUs = 1e300;
+    double firstHitUs = 1e300;
+    double allKeysUs = 1e300;
+    uint64_t startupAllocs = 0;
+};
+
+double usSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+// One process start: startup(cache), then every key requested once
+template<typename Startup>
+void measure(Timings& best, const vector<string>& keys, Startup&& startup) {
+    vector<shared_ptr<Texture>> held;
+    held.reserve(keys.size());
+    const auto start = chrono::steady_clock::now();
+    const uint64_t allocsBefore = bench::allocationCount();
+    Cache cache;
+    auto keepAlive = startup(cache);
+    const uint64_t allocs = bench::allocationCount() - allocsBefore;
+    const double startupUs = usSince(start);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        held.push_back(cache.getOrCreate(keys[i], [&] { return loadTexture(keys[i], i); }));
+        if (i == 0) best.firstHitUs = min(best.firstHitUs, usSince(start));
+    }
+    best.allKeysUs = min(best.allKeysUs, usSince(start));
+    best.startupUs = min(best.startupUs, startupUs);
+    best.startupAllocs = allocs;
+    bench::doNotOptimize(keepAlive);
+}
+
+void printTable(const char* title) {
+    printf("\n%s\n%-44s %12s %12s\n", title, "benchmark", "us", "allocs");
+}
+
+// allocs < 0: not measured
+void printRow(const char* name, double us, long long allocs = -1) {
+    if (allocs < 0)
+        printf("%-44s %12.1f %12s\n", name, us, "-");
+    else
+        printf("%-44s %12.1f %12lld\n", name, us, allocs);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "cache_snapshot_bench.snap";
+    printf("cache_snapshot benchmarks (%zu textures of %zu bytes, best of %d)\n", kTextures, kTexels, kRuns);
+
+    vector<string> keys;
+    for (size_t i = 0; i < kTextures; ++i) keys.push_back("textures/world/tile_" + to_string(i) + ".png");
+
+    // The previous run: every texture live, then saved
+    double saveUs = 1e300;
+    size_t saved = 0;
+    {
+        Cache cache;
+        vector<shared_ptr<Texture>> held;
+        for (size_t i = 0; i < keys.size(); ++i)
+            held.push_back(cache.getOrCreate(keys[i], [&] { return loadTexture(keys[i], i); }));
+        for (int run = 0; run < kRuns; ++run) {
+            const auto start = chrono::steady_clock::now();
+            saved = smartptrs::save_snapshot(cache, path, [](const Texture& t, string& out) {
+                out.append(reinterpret_cast<const char*>(t.texels.data()), t.texels.size());
+            });
+            saveUs = min(saveUs, usSince(start));
+        }
+    }
+
+    Timings cold, warm;
+    size_t fileSize = 0;
+    for (int run = 0; run < kRuns; ++run) {
+        measure(cold, keys, [](Cache&) { return 0; });
+        measure(warm, keys, [&](Cache& cache) {
+            auto snap = smartptrs::warm_start(cache, path, decodeTexture);
+            fileSize = snap->fileSize();
+            return snap;
+        });
+    }
+
+    char label[64];
+    printTable("startup and first request");
+    printRow("cold: startup (nothing to do)", cold.startupUs, (long long)cold.startupAllocs);
+    printRow("warm: startup (open + mmap + validate)", warm.startupUs, (long long)warm.startupAllocs);
+    printRow("cold: time to first hit (factory)", cold.firstHitUs);
+    printRow("warm: time to first hit (decode)", warm.firstHitUs);
+
+    printTable("every key requested once");
+    snprintf(label, sizeof label, "cold: %zu misses through the factory", kTextures);
+    printRow(label, cold.allKeysUs);
+    snprintf(label, sizeof label, "warm: %zu misses decoded from the snapshot", kTextures);
+    printRow(label, warm.allKeysUs);
+    snprintf(label, sizeof label, "save_snapshot (%zu entries, %zu KiB)", saved, fileSize / 1024);
+    printRow(label, saveUs);
+
+    remove(path);
+    return 0;
+}
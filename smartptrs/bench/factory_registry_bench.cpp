@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * factory_registry_bench.cpp
+ * Name -> unique_ptr<Shape> dispatch: createShape's if-chain of string
+ * compares vs factory_registry's perfect hash, as the type count grows
+ *
+ * For 4, 16 and 64 registered types (names "shape_00"... in random order):
+ *   - lookup only: if-chain position vs factory_registry::index
+ *   - create + destroy: if-chain + make_unique vs create() (new),
+ *     createPooled() (fixed_block_pool) and createIn() (monotonic_arena,
+ *     reset every kKeys objects)
+ *
+ * Build: g++ -std=c++17 -O2 factory_registry_bench.cpp -o factory_registry_bench
+ * Run:   ./factory_registry_bench [ops per row, default 2000000]
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../factory_registry.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct Shape {
+    virtual ~Shape() = default;
+    virtual int sides() const = 0;
+};
+
+template<size_t I>
+struct ShapeName {
+    static_assert(I < 100);
+    static constexpr char value[] = {'s', 'h', 'a', 'p', 'e', '_', char('0' + I / 10), char('0' + I % 10), '\0'};
+};
+
+template<size_t I>
+struct NumberedShape : Shape {
+    static constexpr string_view kFactoryName{ShapeName<I>::value, 8};
+    int extra = int(I);
+    int sides() const override { return int(I) + 3; }
+};
+
+// The old createShape: one string compare per type until a match
+template<size_t... I>
+unique_ptr<Shape> ifChain(const string& type, index_sequence<I...>) {
+    unique_ptr<Shape> out;
+    ((type == NumberedShape<I>::kFactoryName ? (out = make_unique<NumberedShape<I>>(), true) : false) || ...);
+    return out;
+}
+
+template<size_t... I>
+size_t ifChainIndex(const string& type, index_sequence<I...>) {
+    size_t at = 0;
+    ((type == NumberedShape<I>::kFactoryName ? true : (++at, false)) || ...);
+    return at;
+}
+
+template<size_t... I>
+smartptrs::factory_registry<Shape, NumberedShape<I>...> registryFor(index_sequence<I...>);
+
+constexpr size_t kKeys = 4096; // power of two: keys[i & (kKeys - 1)]
+
+template<size_t N>
+void runTypes(size_t ops, mt19937& rng) {
+    using seq = make_index_sequence<N>;
+    using registry = decltype(registryFor(seq{}));
+
+    vector<string> keys(kKeys);
+    for (string& k : keys) k = string(registry::kNames[rng() % N]);
+
+    char title[64];
+    snprintf(title, sizeof title, "%zu types: lookup only", N);
+    bench::printHeader(title);
+    bench::run("if-chain", ops, [&](size_t i) { bench::doNotOptimize(ifChainIndex(keys[i & (kKeys - 1)], seq{})); });
+    bench::run("factory_registry::index", ops, [&](size_t i) {
+        bench::doNotOptimize(registry::index(keys[i & (kKeys - 1)]));
+    });
+
+    snprintf(title, sizeof title, "%zu types: create + destroy", N);
+    bench::printHeader(title);
+    bench::run("if-chain + make_unique", ops, [&](size_t i) {
+        auto p = ifChain(keys[i & (kKeys - 1)], seq{});
+        bench::doNotOptimize(p->sides());
+    });
+    bench::run("factory_registry::create", ops, [&](size_t i) {
+        auto p = registry::create(keys[i & (kKeys - 1)]);
+        bench::doNotOptimize(p->sides());
+    });
+    bench::run("factory_registry::createPooled", ops, [&](size_t i) {
+        auto p = registry::createPooled(keys[i & (kKeys - 1)]);
+        bench::doNotOptimize(p->sides());
+    });
+    smartptrs::monotonic_arena arena;
+    bench::run("factory_registry::createIn (arena)", ops, [&](size_t i) {
+        if ((i & (kKeys - 1)) == 0) arena.reset();
+        auto p = registry::createIn(arena, keys[i & (kKeys - 1)]);
+        bench::doNotOptimize(p->sides());
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t ops = argc > 1 ? size_t(strtoull(argv[1], nullptr, 10)) : 2'000'000;
+    printf("factory_registry benchmarks (%zu ops per row)\n", ops);
+    mt19937 rng(42);
+    runTypes<4>(ops, rng);
+    runTypes<16>(ops, rng);
+    runTypes<64>(ops, rng);
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * local_shared_ptr_bench.cpp
+ * Copy-heavy workloads: std::shared_ptr vs local_shared_ptr vs intrusive_ptr
+ *
+ * Every pointer type runs the same three loops on one thread:
+ *   - copy-assign into a ring of slots (one increment + one decrement; the
+ *     two sources alternate because shared_ptr skips same-block assigns)
+ *   - pass by value through a short call chain
+ *   - copy a vector of pointers (fan-out of a subscriber list)
+ *
+ * Build with -pthread: libstdc++ then uses locked RMWs for shared_ptr, which
+ * is what any real multi-threaded service pays.
+ * Build with -DNDEBUG to drop local_shared_ptr's owner-thread assertions.
+ *
+ * Build: g++ -std=c++17 -O2 -DNDEBUG -pthread local_shared_ptr_bench.cpp -o local_shared_ptr_bench
+ * Run:   ./local_shared_ptr_bench
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../intrusive_ptr.hpp"
+#include "../local_shared_ptr.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using bench::QuietWidget;
+
+struct CountedWidget : QuietWidget, smartptrs::ref_counted<CountedWidget> {
+    using QuietWidget::QuietWidget;
+};
+struct LocalCountedWidget : QuietWidget,
+                            smartptrs::ref_counted<LocalCountedWidget, smartptrs::single_thread_count> {
+    using QuietWidget::QuietWidget;
+};
+
+template<typename Ptr>
+[[gnu::noinline]] int callee(Ptr p, int depth) {
+    return depth == 0 ? p->id : callee(p, depth - 1);
+}
+
+template<typename Ptr>
+void runSuite(const char* label, const Ptr& source, const Ptr& other, size_t iterations) {
+    char name[64];
+
+    // 63 slots: each slot alternates between the two sources
+    vector<Ptr> ring(63);
+    const Ptr* sources[] = {&source, &other};
+    snprintf(name, sizeof name, "%s copy-assign", label);
+    bench::run(name, iterations, [&](size_t i) {
+        ring[i % 63] = *sources[i & 1];
+        bench::doNotOptimize(ring[i % 63]);
+    });
+
+    snprintf(name, sizeof name, "%s pass by value x4", label);
+    bench::run(name, iterations / 4, [&](size_t) {
+        bench::doNotOptimize(callee(source, 3));
+    });
+
+    vector<Ptr> subscribers(256, source);
+    snprintf(name, sizeof name, "%s copy vector<256>", label);
+    bench::run(name, iterations / 256, [&](size_t) {
+        vector<Ptr> snapshot = subscribers;
+        bench::doNotOptimize(snapshot.data());
+    });
+}
+
+int main() {
+    // Make sure the process is multi-threaded, as a real service would be
+    thread([] {}).join();
+
+    const size_t iterations = 20000000;
+    bench::printHeader("single-threaded copy-heavy workloads");
+    runSuite("std::shared_ptr      ", make_shared<QuietWidget>(1, "a"),
+             make_shared<QuietWidget>(2, "b"), iterations);
+    runSuite("local_shared_ptr     ", smartptrs::make_local_shared<QuietWidget>(1, "a"),
+             smartptrs::make_local_shared<QuietWidget>(2, "b"), iterations);
+    runSuite("intrusive (atomic)   ", smartptrs::make_intrusive<CountedWidget>(1, "a"),
+             smartptrs::make_intrusive<CountedWidget>(2, "b"), iterations);
+    runSuite("intrusive (local)    ", smartptrs::make_intrusive<LocalCountedWidget>(1, "a"),
+             smartptrs::make_intrusive<LocalCountedWidget>(2, "b"), iterations);
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*******************************************************************************
+ * padded_shared_bench.cpp
+ * False sharing between the control block and the object: make_shared vs
+ * make_shared_padded, measured with hardware cache-miss counters
+ *
+ *   - one Widget, two threads: one writes w->id, the other copies and drops
+ *     the shared_ptr (both counts and id on one line with make_shared)
+ *   - per-thread counters in one array: thread k increments element k of
+ *     make_shared_array<long> (8 per line) vs make_shared_padded_array
+ *
+ * Each worker counts its own L1D load misses and last-level cache misses
+ * with perf_event_open (user space only); the columns are the totals of
+ * all workers divided by all ops. Without counter access (non-Linux,
+ * containers, kernel.perf_event_paranoid > 2) they show n/a and only the
+ * timings are meaningful. False sharing needs the threads on different
+ * cores: on a single CPU both layouts cost the same.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread padded_shared_bench.cpp -o padded_shared_bench
+ * Run:   ./padded_shared_bench [array threads, default 2,4,8]
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../padded_shared.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using bench::QuietWidget;
+
+namespace {
+
+constexpr size_t kIterations = 2'000'000;
+
+// One hardware counter for the calling thread; inert if unavailable
+class PerfCounter {
+public:
+    PerfCounter(uint32_t type, uint64_t config) {
+#if defined(__linux__)
+        perf_event_attr attr{};
+        attr.size = sizeof attr;
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)type;
+        (void)config;
+#endif
+    }
+    ~PerfCounter() {
+#if defined(__linux__)
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    bool ok() const noexcept { return fd_ >= 0; }
+
+    void start() noexcept {
+#if defined(__linux__)
+        if (!ok()) return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    uint64_t stop() noexcept {
+        uint64_t value = 0;
+#if defined(__linux__)
+        if (!ok()) return 0;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &value, sizeof value) != ssize_t(sizeof value)) value = 0;
+#endif
+        return value;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+#if defined(__linux__)
+constexpr uint64_t kL1dLoadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                  (uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+PerfCounter l1dMisses() { return PerfCounter(PERF_TYPE_HW_CACHE, kL1dLoadMiss); }
+PerfCounter llcMisses() { return PerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES); }
+#else
+PerfCounter l1dMisses() { return PerfCounter(0, 0); }
+PerfCounter llcMisses() { return PerfCounter(0, 0); }
+#endif
+
+void printHeader(const char* title) {
+    printf("\n%s\n%-44s %12s %12s %12s\n", title, "benchmark", "ns/op", "L1D miss/op", "LLC miss/op");
+}
+
+// Runs fn(t, i) for i in [0, kIterations) on `threads` threads released
+// together, each counting its own misses; prints one row
+template<typename Fn>
+void runCounted(const char* name, size_t threads, Fn&& fn) {
+    atomic<size_t> ready{0};
+    atomic<bool> go{false};
+    atomic<uint64_t> l1d{0}, llc{0};
+    atomic<bool> counted{true};
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            PerfCounter a = l1dMisses();
+            PerfCounter b = llcMisses();
+            if (!a.ok() || !b.ok()) counted.store(false);
+            for (size_t i = 0; i < kIterations / 10 + 1; ++i) fn(t, i);
+            ready.fetch_add(1);
+            while (!go.load(memory_order_acquire)) this_thread::yield();
+            a.start();
+            b.start();
+            for (size_t i = 0; i < kIterations; ++i) fn(t, i);
+            l1d.fetch_add(a.stop());
+            llc.fetch_add(b.stop());
+        });
+    }
+    while (ready.load() != threads) this_thread::yield();
+    const auto start = chrono::steady_clock::now();
+    go.store(true, memory_order_release);
+    for (auto& w : workers) w.join();
+    const double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+    char label[96];
+    snprintf(label, sizeof label, "%s [%zu thr]", name, threads);
+    const double ops = double(kIterations) * double(threads);
+    if (counted.load())
+        printf("%-44s %12.2f %12.3f %12.3f\n", label, ns / double(kIterations), double(l1d) / ops, double(llc) / ops);
+    else
+        printf("%-44s %12.2f %12s %12s\n", label, ns / double(kIterations), "n/a", "n/a");
+}
+
+// Thread 0 writes the id, thread 1 copies the pointer
+void writerAndCopier(const char* name, const shared_ptr<QuietWidget>& w) {
+    runCounted(name, 2, [&](size_t t, size_t i) {
+        if (t == 0) {
+            w->id = int(i);
+            bench::doNotOptimize(w->id);
+        } else {
+            shared_ptr<QuietWidget> copy = w;
+            bench::doNotOptimize(copy);
+        }
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const vector<size_t> threads = bench::threadCounts(argc, argv, 1, {2, 4, 8});
+    printf("padded_shared benchmarks (%zu ops per thread, %u CPUs)\n", kIterations, thread::hardware_concurrency());
+    {
+        PerfCounter probe = l1dMisses();
+        if (!probe.ok()) printf("hardware counters unavailable: miss columns show n/a\n");
+    }
+
+    printHeader("one Widget: writer of id + copier of shared_ptr");
+    writerAndCopier("make_shared", make_shared<QuietWidget>(1));
+    writerAndCopier("make_shared_padded", smartptrs::make_shared_padded<QuietWidget>(1));
+
+    printHeader("per-thread counters in one shared array");
+    for (size_t t : threads) {
+        auto packed = smartptrs::make_shared_array<long>(t);
+        runCounted("make_shared_array<long>", t, [&](size_t k, size_t) {
+            ++packed[k];
+            bench::doNotOptimize(packed[k]);
+        });
+        auto padded = smartptrs::make_shared_padded_array<long>(t);
+        runCounted("make_shared_padded_array<long>", t, [&](size_t k, size_t) {
+            ++padded[k].value;
+            bench::doNotOptimize(padded[k].value);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+/*******************************************************************************
+ * pointer_ops_bench.cpp
+ * Every smart pointer operation the tutorial's PERFORMANCE TIPS talk about
+ *
+ * Each operation is timed in isolation, on one thread and on several:
+ *   - create/destroy: new/delete, make_unique, unique_ptr(new),
+ *     make_shared, shared_ptr(new)
+ *   - shared_ptr copy, weak_ptr::lock and use_count, both on one object
+ *     shared by every thread ("contended") and on a per-thread object
+ *   - unique_ptr and shared_ptr move
+ *   - unique_ptr with custom deleters: size and create/destroy time
+ *   - passing shared_ptr by value vs by const& through a call chain
+ *   - make_shared<Widget> with its lifecycle trace compiled away vs
+ *     logged to a per-thread buffer (trace.hpp)
+ *
+ * Multi-thread rows report wall time per op per thread, so perfect scaling
+ * keeps ns/op flat as the thread count grows.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread pointer_ops_bench.cpp -o pointer_ops_bench
+ * Run:   ./pointer_ops_bench [threads, default 1,2,4,8]
+ ******************************************************************************/
+
+#include "bench.hpp"
+
+#include "../demo_types.hpp"
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace std;
+using bench::QuietWidget;
+
+namespace {
+
+constexpr size_t kIterations = 1'000'000;
+
+// Per-thread state, padded so neighbouring threads don't share a line
+struct alignas(64) Local {
+    shared_ptr<QuietWidget> shared;
+    weak_ptr<QuietWidget> weak;
+};
+
+struct WidgetDeleter {
+    void operator()(QuietWidget* w) const noexcept { delete w; }
+};
+
+void deleteWidget(QuietWidget* w) noexcept { delete w; }
+
+// Call chains: the pointer is forwarded three levels deep
+__attribute__((noinline)) int byValue3(shared_ptr<QuietWidget> w) { return w->id; }
+__attribute__((noinline)) int byValue2(shared_ptr<QuietWidget> w) { return byValue3(w); }
+__attribute__((noinline)) int byValue1(shared_ptr<QuietWidget> w) { return byValue2(w); }
+
+__attribute__((noinline)) int byRef3(const shared_ptr<QuietWidget>& w) { return w->id; }
+__attribute__((noinline)) int byRef2(const shared_ptr<QuietWidget>& w) { return byRef3(w); }
+__attribute__((noinline)) int byRef1(const shared_ptr<QuietWidget>& w) { return byRef2(w); }
+
+void createDestroy(const vector<size_t>& threads) {
+    bench::printHeader("create/destroy");
+    for (size_t t : threads) {
+        bench::runThreads("new/delete", t, kIterations, [](size_t, size_t i) {
+            auto* w = new QuietWidget(int(i));
+            bench::doNotOptimize(w);
+            delete w;
+        });
+        bench::runThreads("make_unique", t, kIterations, [](size_t, size_t i) {
+            auto w = make_unique<QuietWidget>(int(i));
+            bench::doNotOptimize(w);
+        });
+        bench::runThreads("unique_ptr(new)", t, kIterations, [](size_t, size_t i) {
+            unique_ptr<QuietWidget> w(new QuietWidget(int(i)));
+            bench::doNotOptimize(w);
+        });
+        bench::runThreads("make_shared", t, kIterations, [](size_t, size_t i) {
+            auto w = make_shared<QuietWidget>(int(i));
+            bench::doNotOptimize(w);
+        });
+        bench::runThreads("shared_ptr(new)", t, kIterations, [](size_t, size_t i) {
+            shared_ptr<QuietWidget> w(new QuietWidget(int(i)));
+            bench::doNotOptimize(w);
+        });
+    }
+}
+
+void copyLockUseCount(const vector<size_t>& threads) {
+    auto common = make_shared<QuietWidget>(0);
+    const weak_ptr<QuietWidget> commonWeak = common;
+
+    bench::printHeader("shared_ptr copy / weak_ptr::lock / use_count");
+    for (size_t t : threads) {
+        vector<Local> locals(t);
+        for (size_t i = 0; i < t; ++i) {
+            locals[i].shared = make_shared<QuietWidget>(int(i));
+            locals[i].weak = locals[i].shared;
+        }
+
+        bench::runThreads("copy, contended", t, kIterations, [&](size_t, size_t) {
+            shared_ptr<QuietWidget> copy = common;
+            bench::doNotOptimize(copy);
+        });
+        bench::runThreads("copy, per-thread object", t, kIterations, [&](size_t k, size_t) {
+            shared_ptr<QuietWidget> copy = locals[k].shared;
+            bench::doNotOptimize(copy);
+        });
+        bench::runThreads("weak_ptr::lock, contended", t, kIterations, [&](size_t, size_t) {
+            shared_ptr<QuietWidget> locked = commonWeak.lock();
+            bench::doNotOptimize(locked);
+        });
+        bench::runThreads("weak_ptr::lock, per-thread object", t, kIterations, [&](size_t k, size_t) {
+            shared_ptr<QuietWidget> locked = locals[k].weak.lock();
+            bench::doNotOptimize(locked);
+        });
+        bench::runThreads("use_count, contended", t, kIterations, [&](size_t, size_t) {
+            bench::doNotOptimize(common.use_count());
+        });
+    }
+}
+
+void moves(const vector<size_t>& threads) {
+    bench::printHeader("move (ping-pong between two locals)");
+    for (size_t t : threads) {
+        bench::runThreads("unique_ptr move", t, kIterations, [](size_t, size_t) {
+            static thread_local unique_ptr<QuietWidget> a = make_unique<QuietWidget>(1);
+            static thread_local unique_ptr<QuietWidget> b;
+            b = std::move(a);
+            bench::doNotOptimize(b);
+            a = std::move(b);
+        });
+        bench::runThreads("shared_ptr move", t, kIterations, [](size_t, size_t) {
+            static thread_local shared_ptr<QuietWidget> a = make_shared<QuietWidget>(1);
+            static thread_local shared_ptr<QuietWidget> b;
+            b = std::move(a);
+            bench::doNotOptimize(b);
+            a = std::move(b);
+        });
+    }
+}
+
+void customDeleters(const vector<size_t>& threads) {
+    const int offset = 0;
+    auto statelessLambda = [](QuietWidget* w) noexcept { delete w; };
+    auto statefulLambda = [offset](QuietWidget* w) noexcept { delete (w + offset); };
+    using FnPtr = void (*)(QuietWidget*) noexcept;
+    using StdFunction = function<void(QuietWidget*)>;
+
+    printf("\nsizeof unique_ptr<QuietWidget, D>:\n");
+    printf("  %-40s %zu\n", "default_delete", sizeof(unique_ptr<QuietWidget>));
+    printf("  %-40s %zu\n", "stateless functor", sizeof(unique_ptr<QuietWidget, WidgetDeleter>));
+    printf("  %-40s %zu\n", "stateless lambda", sizeof(unique_ptr<QuietWidget, decltype(statelessLambda)>));
+    printf("  %-40s %zu\n", "function pointer", sizeof(unique_ptr<QuietWidget, FnPtr>));
+    printf("  %-40s %zu\n", "lambda capturing an int", sizeof(unique_ptr<QuietWidget, decltype(statefulLambda)>));
+    printf("  %-40s %zu\n", "std::function", sizeof(unique_ptr<QuietWidget, StdFunction>));
+
+    bench::printHeader("unique_ptr with custom deleter, create/destroy");
+    for (size_t t : threads) {
+        bench::runThreads("stateless functor", t, kIterations, [](size_t, size_t i) {
+            unique_ptr<QuietWidget, WidgetDeleter> w(new QuietWidget(int(i)));
+            bench::doNotOptimize(w);
+        });
+        bench::runThreads("stateless lambda", t, kIterations, [&](size_t, size_t i) {
+            unique_ptr<QuietWidget, decltype(statelessLambda)> w(new QuietWidget(int(i)), statelessLambda);
+            bench::doNotOptimize(w);
+        });
+        bench::runThreads("function pointer", t, kIterations, [](size_t, size_t i) {
+            unique_ptr<QuietWidget, FnPtr> w(new QuietWidget(int(i)), &deleteWidget);
+            bench::doNotOptimize(w);
+        });
+        bench::runThreads("lambda capturing an int", t, kIterations, [&](size_t, size_t i) {
+            unique_ptr<QuietWidget, decltype(statefulLambda)> w(new QuietWidget(int(i)), statefulLambda);
+            bench::doNotOptimize(w);
+        });
+        bench::runThreads("std::function", t, kIterations, [](size_t, size_t i) {
+            unique_ptr<QuietWidget, StdFunction> w(new QuietWidget(int(i)), &deleteWidget);
+            bench::doNotOptimize(w);
+        });
+    }
+}
+
+void passing(const vector<size_t>& threads) {
+    auto common = make_shared<QuietWidget>(7);
+
+    bench::printHeader("pass shared_ptr through 3 calls");
+    for (size_t t : threads) {
+        vector<Local> locals(t);
+        for (size_t i = 0; i < t; ++i) locals[i].shared = make_shared<QuietWidget>(int(i));
+
+        bench::runThreads("by value, contended", t, kIterations, [&](size_t, size_t) {
+            bench::doNotOptimize(byValue1(common));
+        });
+        bench::runThreads("by value, per-thread object", t, kIterations, [&](size_t k, size_t) {
+            bench::doNotOptimize(byValue1(locals[k].shared));
+        });
+        bench::runThreads("by const&, contended", t, kIterations, [&](size_t, size_t) {
+            bench::doNotOptimize(byRef1(common));
+        });
+    }
+}
+
+void tracePolicies(const vector<size_t>& threads) {
+    using BufferedWidget = smartptrs::BasicWidget<smartptrs::buffered_trace>;
+
+    bench::printHeader("make_shared<Widget> by trace policy");
+    for (size_t t : threads) {
+        bench::runThreads("no_trace", t, kIterations, [](size_t, size_t i) {
+            auto w = make_shared<QuietWidget>(int(i), "traced");
+            bench::doNotOptimize(w);
+        });
+        bench::runThreads("buffered_trace", t, kIterations, [](size_t, size_t i) {
+            auto w = make_shared<BufferedWidget>(int(i), "traced");
+            bench::doNotOptimize(w);
+            if (i % 4096 == 4095) smartptrs::buffered_trace::discard(); // bound the buffer
+        });
+    }
+    smartptrs::buffered_trace::discard();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const vector<size_t> threads = bench::threadCounts(argc, argv, 1);
+
+    printf("Pointer operation benchmarks (%zu iterations per thread)\n", kIterations);
+    createDestroy(threads);
+    copyLockUseCount(threads);
+    moves(threads);
+    customDeleters(threads);
+    passing(threads);
+    tracePolicies(threads);
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * poly_value_bench.cpp
+ * Containers of mixed shapes: vector<unique_ptr<Shape>> vs
+ * vector<poly_value<Shape, 32>>
+ *
+ * The mix is 40% Circle and 40% Square (empty), 15% Rect (two doubles) and
+ * 5% Polygon (96 bytes: too big for the buffer, so poly_value puts it on
+ * the heap), in random order. ns/op is per element for each phase:
+ *   - construction: push_back into a reserved vector
+ *   - iteration: one virtual draw() per element
+ *   - destruction: pop_back
+ *
+ * Build: g++ -std=c++17 -O2 poly_value_bench.cpp -o poly_value_bench
+ * Run:   ./poly_value_bench [shapes, default 1000000]
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../poly_value.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct Shape {
+    virtual ~Shape() = default;
+    virtual double draw() const = 0;
+};
+
+struct Circle : Shape {
+    double draw() const override { return 3.14159; }
+};
+
+struct Square : Shape {
+    double draw() const override { return 1.0; }
+};
+
+struct Rect : Shape {
+    double w = 2.0, h = 3.0;
+    double draw() const override { return w * h; }
+};
+
+struct Polygon : Shape {
+    double xs[6] = {0, 1, 1, 0, 0.5, 0.2};
+    double ys[6] = {0, 0, 1, 1, 1.5, 0.7};
+    double draw() const override { return xs[4] * ys[4]; }
+};
+
+using PolyShape = smartptrs::poly_value<Shape, 32>;
+static_assert(PolyShape::fits_inline<Rect> && !PolyShape::fits_inline<Polygon>);
+
+enum class Kind { circle, square, rect, polygon };
+
+unique_ptr<Shape> makeUnique(Kind k) {
+    switch (k) {
+    case Kind::circle: return make_unique<Circle>();
+    case Kind::square: return make_unique<Square>();
+    case Kind::rect: return make_unique<Rect>();
+    default: return make_unique<Polygon>();
+    }
+}
+
+PolyShape makePoly(Kind k) {
+    switch (k) {
+    case Kind::circle: return Circle{};
+    case Kind::square: return Square{};
+    case Kind::rect: return Rect{};
+    default: return Polygon{};
+    }
+}
+
+template<typename Ptr, typename Make>
+void runContainer(const char* label, const vector<Kind>& kinds, Make make) {
+    const size_t n = kinds.size();
+    vector<Ptr> shapes;
+    shapes.reserve(n + n / 10 + 1); // run() warms up with n / 10 + 1 extra calls
+    char name[64];
+
+    snprintf(name, sizeof name, "%s construct", label);
+    bench::run(name, n, [&](size_t i) { shapes.push_back(make(kinds[i % n])); });
+
+    snprintf(name, sizeof name, "%s iterate + draw()", label);
+    double sum = 0;
+    bench::run(name, n, [&](size_t i) { sum += shapes[i]->draw(); });
+    bench::doNotOptimize(sum);
+
+    snprintf(name, sizeof name, "%s destroy", label);
+    bench::run(name, n, [&](size_t) { shapes.pop_back(); });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t n = argc > 1 ? size_t(strtoull(argv[1], nullptr, 10)) : 1'000'000;
+    printf("poly_value benchmarks (%zu shapes, sizeof(poly_value<Shape, 32>) = %zu)\n", n, sizeof(PolyShape));
+
+    mt19937 rng(42);
+    vector<Kind> kinds(n);
+    for (Kind& k : kinds) {
+        const unsigned r = rng() % 100;
+        k = r < 40 ? Kind::circle : r < 80 ? Kind::square : r < 95 ? Kind::rect : Kind::polygon;
+    }
+
+    bench::printHeader("vector<unique_ptr<Shape>>");
+    runContainer<unique_ptr<Shape>>("unique_ptr", kinds, makeUnique);
+    bench::printHeader("vector<poly_value<Shape, 32>>");
+    runContainer<PolyShape>("poly_value", kinds, makePoly);
+    return 0;
+}
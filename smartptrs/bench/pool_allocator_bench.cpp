@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * pool_allocator_bench.cpp
+ * Creating and destroying millions of Widgets: new vs make_shared vs
+ * allocate_shared with pool_allocator vs recycling through ObjectPool
+ *
+ * Two patterns per strategy:
+ *   - churn: create and immediately destroy (best case for malloc's
+ *     per-thread cache too)
+ *   - batch: create N objects, then destroy all of them (the shape of a
+ *     request that builds a working set and drops it); ns/op is per object
+ * plus a multi-threaded batch where each thread runs its own loop.
+ * ObjectPool keeps at most kMaxIdle objects idle, so batches larger than
+ * that mostly miss; its hit rate and peak size are printed at the end.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread pool_allocator_bench.cpp -o pool_allocator_bench
+ * Run:   ./pool_allocator_bench [objects-per-batch] [threads]
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../object_pool.hpp"
+#include "../pool_allocator.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using bench::QuietWidget;
+
+struct NewDelete {
+    using pointer = unique_ptr<QuietWidget>;
+    static pointer make(int i) { return pointer(new QuietWidget(i)); }
+};
+struct MakeShared {
+    using pointer = shared_ptr<QuietWidget>;
+    static pointer make(int i) { return make_shared<QuietWidget>(i); }
+};
+struct PoolShared {
+    using pointer = shared_ptr<QuietWidget>;
+    static pointer make(int i) {
+        return allocate_shared<QuietWidget>(smartptrs::pool_allocator<QuietWidget>(), i);
+    }
+};
+
+struct Recycled {
+    using pool = smartptrs::ObjectPool<QuietWidget>;
+    using pointer = pool::handle;
+    static pointer make(int i) { return pool::acquire(i); }
+};
+
+template<typename Strategy>
+void runStrategy(const char* label, size_t batch, size_t threads) {
+    char name[64];
+    snprintf(name, sizeof name, "%s churn", label);
+    bench::run(name, batch * 4, [](size_t i) {
+        auto p = Strategy::make(int(i));
+        bench::doNotOptimize(p.get());
+    });
+
+    // One op = create one object; every `batch` ops the whole set is dropped
+    vector<typename Strategy::pointer> objects;
+    objects.reserve(batch);
+    snprintf(name, sizeof name, "%s batch", label);
+    bench::run(name, batch * 4, [&](size_t i) {
+        objects.push_back(Strategy::make(int(i)));
+        if (objects.size() == batch) objects.clear();
+    });
+    objects.clear();
+
+    // Same batch loop on several threads at once
+    atomic<uint64_t> allocs{0};
+    const size_t perThread = batch * 4;
+    const auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            const uint64_t before = bench::allocationCount();
+            vector<typename Strategy::pointer> local;
+            local.reserve(batch);
+            for (size_t i = 0; i < perThread; ++i) {
+                local.push_back(Strategy::make(int(i)));
+                if (local.size() == batch) local.clear();
+            }
+            allocs += bench::allocationCount() - before;
+        });
+    }
+    for (auto& w : workers) w.join();
+    const double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    const double ops = double(perThread * threads);
+    snprintf(name, sizeof name, "%s batch x%zu threads", label, threads);
+    bench::printRow(name, {ns / ops, double(allocs.load()) / ops});
+}
+
+int main(int argc, char** argv) {
+    const size_t batch = argc > 1 ? stoul(argv[1]) : 1000000;
+    const size_t threads = argc > 2 ? stoul(argv[2]) : 4;
+
+    printf("working set of %zu objects per batch\n", batch);
+    bench::printHeader("Widget create/destroy");
+    runStrategy<NewDelete>("new/delete          ", batch, threads);
+    runStrategy<MakeShared>("make_shared         ", batch, threads);
+    runStrategy<PoolShared>("allocate_shared pool", batch, threads);
+    runStrategy<Recycled>("ObjectPool::acquire ", batch, threads);
+
+    const smartptrs::pool_stats stats = Recycled::pool::stats();
+    printf("\nObjectPool: hit rate %.1f%%, peak size %zu objects\n", 100.0 * stats.hitRate(), stats.peakSize);
+    return 0;
+}
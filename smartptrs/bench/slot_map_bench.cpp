@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * slot_map_bench.cpp
+ * Iterating millions of Widgets: vector<unique_ptr<Widget>> vs slot_map
+ *
+ * One op reads one element's id:
+ *   - vector<unique_ptr> scan, Widgets allocated in order (best case: the
+ *     heap blocks happen to be adjacent)
+ *   - vector<unique_ptr> scan after churn: the vector order no longer
+ *     matches heap order, as after erases/inserts in a long-running process
+ *   - slot_map scan (contiguous values)
+ *   - lookups through random handles: unique_ptr* vs slot_map::get()
+ *
+ * Build: g++ -std=c++17 -O2 slot_map_bench.cpp -o slot_map_bench
+ * Run:   ./slot_map_bench [widgets, default 1000000]
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../slot_map.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+using bench::QuietWidget;
+
+int main(int argc, char** argv) {
+    const size_t n = argc > 1 ? size_t(strtoull(argv[1], nullptr, 10)) : 1'000'000;
+    printf("slot_map benchmarks (%zu widgets)\n", n);
+    mt19937 rng(42);
+
+    vector<unique_ptr<QuietWidget>> ordered;
+    ordered.reserve(n);
+    for (size_t i = 0; i < n; ++i) ordered.push_back(make_unique<QuietWidget>(int(i)));
+
+    vector<unique_ptr<QuietWidget>> churned;
+    churned.reserve(n);
+    for (size_t i = 0; i < n; ++i) churned.push_back(make_unique<QuietWidget>(int(i)));
+    shuffle(churned.begin(), churned.end(), rng);
+
+    smartptrs::slot_map<QuietWidget> slots;
+    slots.reserve(n);
+    vector<smartptrs::slot_map<QuietWidget>::handle> handles;
+    handles.reserve(n);
+    for (size_t i = 0; i < n; ++i) handles.push_back(slots.insert(int(i)));
+
+    // The same random visiting order for both lookup rows
+    vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = i;
+    shuffle(order.begin(), order.end(), rng);
+
+    bench::printHeader("Sequential scan (per element)");
+    long sum = 0;
+    bench::run("vector<unique_ptr> (alloc order)", n, [&](size_t i) { sum += ordered[i]->id; });
+    bench::run("vector<unique_ptr> (after churn)", n, [&](size_t i) { sum += churned[i]->id; });
+    const QuietWidget* dense = slots.data();
+    bench::run("slot_map", n, [&](size_t i) { sum += dense[i].id; });
+
+    bench::printHeader("Random lookup (per element)");
+    bench::run("unique_ptr deref", n, [&](size_t i) { sum += ordered[order[i]]->id; });
+    bench::run("slot_map::get(handle)", n, [&](size_t i) { sum += slots.get(handles[order[i]])->id; });
+    bench::doNotOptimize(sum);
+
+    printf("\nsizeof handle: %zu (unique_ptr %zu, weak_ptr %zu)\n",
+           sizeof(smartptrs::slot_map<QuietWidget>::handle), sizeof(unique_ptr<QuietWidget>),
+           sizeof(weak_ptr<QuietWidget>));
+    return 0;
+}
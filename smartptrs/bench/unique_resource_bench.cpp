@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * unique_resource_bench.cpp
+ * unique_resource vs hand-written deleters for C handles
+ *
+ *   - sizes: unique_resource vs unique_ptr with functor, function-pointer
+ *     and capturing-lambda deleters
+ *   - wrapper cost alone: acquire/release of a fake handle whose close is
+ *     one add, so any indirect call or extra word shows up
+ *   - real resources: fopen/fclose and open/close on /dev/null, raw vs
+ *     unique_ptr<FILE, FileCloser> vs unique_file / unique_fd
+ *
+ * Build: g++ -std=c++17 -O2 unique_resource_bench.cpp -o unique_resource_bench
+ * Run:   ./unique_resource_bench
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../unique_resource.hpp"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <memory>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t kIterations = 10'000'000;
+constexpr size_t kSyscallIterations = 200'000;
+
+// The tutorial's FILE* deleter, without the trace line
+struct FileCloser {
+    void operator()(FILE* fp) const {
+        if (fp) fclose(fp);
+    }
+};
+
+// Fake handle: "closing" adds to a counter, so the wrapper is all that's timed
+size_t closed = 0;
+int closeToken(int t) noexcept {
+    closed += size_t(t);
+    return 0;
+}
+
+struct Token {
+    int value;
+};
+struct TokenCloser {
+    void operator()(Token* t) const noexcept { closeToken(t->value); }
+};
+using TokenCloseFn = void (*)(Token*);
+void closeTokenPtr(Token* t) noexcept { closeToken(t->value); }
+
+using unique_token = smartptrs::unique_resource<int, &closeToken, -1>;
+
+} // namespace
+
+int main() {
+    printf("unique_resource benchmarks\n");
+
+    auto capturing = [n = 0](FILE* fp) { if (fp) fclose(fp); return n; };
+    printf("\nsizeof:\n");
+    printf("  %-40s %zu\n", "unique_file", sizeof(smartptrs::unique_file));
+    printf("  %-40s %zu\n", "unique_fd", sizeof(smartptrs::unique_fd));
+    printf("  %-40s %zu\n", "unique_ptr<FILE, FileCloser>", sizeof(unique_ptr<FILE, FileCloser>));
+    printf("  %-40s %zu\n", "unique_ptr<FILE, int(*)(FILE*)>", sizeof(unique_ptr<FILE, int (*)(FILE*)>));
+    printf("  %-40s %zu\n", "unique_ptr<FILE, capturing lambda>",
+           sizeof(unique_ptr<FILE, decltype(capturing)>));
+
+    bench::printHeader("Wrapper cost (fake handle, close = one add)");
+    Token token{1};
+    bench::run("raw acquire + close", kIterations, [&](size_t i) {
+        int h = int(i & 1);
+        bench::doNotOptimize(h);
+        closeToken(h);
+    });
+    bench::run("unique_resource<int, closeToken>", kIterations, [&](size_t i) {
+        unique_token h(int(i & 1));
+        bench::doNotOptimize(h);
+    });
+    bench::run("unique_ptr<Token, TokenCloser>", kIterations, [&](size_t) {
+        unique_ptr<Token, TokenCloser> h(&token);
+        bench::doNotOptimize(h);
+    });
+    bench::run("unique_ptr<Token, void(*)(Token*)>", kIterations, [&](size_t) {
+        unique_ptr<Token, TokenCloseFn> h(&token, &closeTokenPtr);
+        bench::doNotOptimize(h);
+    });
+    bench::doNotOptimize(closed);
+
+    bench::printHeader("fopen/fclose(/dev/null)");
+    bench::run("raw FILE*", kSyscallIterations, [](size_t) {
+        FILE* fp = fopen("/dev/null", "r");
+        bench::doNotOptimize(fp);
+        if (fp) fclose(fp);
+    });
+    bench::run("unique_ptr<FILE, FileCloser>", kSyscallIterations, [](size_t) {
+        unique_ptr<FILE, FileCloser> fp(fopen("/dev/null", "r"));
+        bench::doNotOptimize(fp);
+    });
+    bench::run("unique_file", kSyscallIterations, [](size_t) {
+        smartptrs::unique_file fp(fopen("/dev/null", "r"));
+        bench::doNotOptimize(fp);
+    });
+
+    bench::printHeader("open/close(/dev/null)");
+    bench::run("raw int fd", kSyscallIterations, [](size_t) {
+        int fd = open("/dev/null", O_RDONLY);
+        bench::doNotOptimize(fd);
+        if (fd != -1) close(fd);
+    });
+    bench::run("unique_fd", kSyscallIterations, [](size_t) {
+        smartptrs::unique_fd fd(open("/dev/null", O_RDONLY));
+        bench::doNotOptimize(fd);
+    });
+    return 0;
+}
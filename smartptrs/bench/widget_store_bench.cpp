@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * widget_store_bench.cpp
+ * Bulk id queries: vector<unique_ptr<Widget>> vs vector<Widget> vs the
+ * structure-of-arrays WidgetStore
+ *
+ * One op is one whole query over all widgets (every 16th erased):
+ *   - findId of an id that isn't there (full scan)
+ *   - count live entries
+ *   - filter an id range matching ~10% of entries
+ * The backend line says whether the WidgetStore rows used AVX2, NEON or
+ * scalar code.
+ *
+ * Build: g++ -std=c++17 -O2 -march=native widget_store_bench.cpp -o widget_store_bench
+ * Run:   ./widget_store_bench [widgets, default 1000000]
+ ******************************************************************************/
+
+#include "bench.hpp"
+#include "../widget_store.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+using bench::QuietWidget;
+
+namespace {
+
+constexpr size_t kQueries = 50;
+
+// Baseline element: the Widget plus the liveness flag a plain vector needs
+struct Slot {
+    QuietWidget widget;
+    bool live;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t n = argc > 1 ? size_t(strtoull(argv[1], nullptr, 10)) : 1'000'000;
+    printf("WidgetStore benchmarks (%zu widgets, backend %s)\n", n, smartptrs::WidgetStore::simdBackend());
+
+    vector<unique_ptr<Slot>> pointers;
+    vector<Slot> objects;
+    auto store = smartptrs::WidgetStore::create(n);
+    pointers.reserve(n);
+    objects.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        const string name = "widget-" + to_string(i);
+        pointers.push_back(make_unique<Slot>(Slot{QuietWidget(int(i), name), i % 16 != 0}));
+        objects.push_back(Slot{QuietWidget(int(i), name), i % 16 != 0});
+        store->add(int(i), name);
+        if (i % 16 == 0) store->erase(i);
+    }
+    const int missing = -1;
+    const int lo = int(n / 2), hi = int(n / 2 + n / 10);
+
+    bench::printHeader("findId (absent id, full scan)");
+    bench::run("vector<unique_ptr<Widget>>", kQueries, [&](size_t) {
+        size_t found = n;
+        for (size_t i = 0; i < n; ++i) {
+            if (pointers[i]->live && pointers[i]->widget.id == missing) { found = i; break; }
+        }
+        bench::doNotOptimize(found);
+    });
+    bench::run("vector<Widget>", kQueries, [&](size_t) {
+        size_t found = n;
+        for (size_t i = 0; i < n; ++i) {
+            if (objects[i].live && objects[i].widget.id == missing) { found = i; break; }
+        }
+        bench::doNotOptimize(found);
+    });
+    bench::run("WidgetStore::findId", kQueries, [&](size_t) { bench::doNotOptimize(store->findId(missing)); });
+
+    bench::printHeader("count live");
+    bench::run("vector<unique_ptr<Widget>>", kQueries, [&](size_t) {
+        size_t live = 0;
+        for (const auto& p : pointers) live += p->live;
+        bench::doNotOptimize(live);
+    });
+    bench::run("vector<Widget>", kQueries, [&](size_t) {
+        size_t live = 0;
+        for (const auto& o : objects) live += o.live;
+        bench::doNotOptimize(live);
+    });
+    bench::run("WidgetStore::countLive", kQueries, [&](size_t) { bench::doNotOptimize(store->countLive()); });
+
+    bench::printHeader("filter id range (~10% match)");
+    vector<size_t> hits;
+    hits.reserve(n);
+    bench::run("vector<unique_ptr<Widget>>", kQueries, [&](size_t) {
+        hits.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const Slot& s = *pointers[i];
+            if (s.live && s.widget.id >= lo && s.widget.id <= hi) hits.push_back(i);
+        }
+        bench::doNotOptimize(hits.size());
+    });
+    bench::run("vector<Widget>", kQueries, [&](size_t) {
+        hits.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const Slot& s = objects[i];
+            if (s.live && s.widget.id >= lo && s.widget.id <= hi) hits.push_back(i);
+        }
+        bench::doNotOptimize(hits.size());
+    });
+    bench::run("WidgetStore::filterIdRange", kQueries, [&](size_t) {
+        hits.clear();
+        store->filterIdRange(lo, hi, hits);
+        bench::doNotOptimize(hits.size());
+    });
+    return 0;
+}
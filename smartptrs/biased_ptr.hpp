@@ -0,0 +1,396 @@
+/*******************************************************************************
+ * biased_ptr.hpp
+ * Shared ownership with biased reference counting
+ *
+ * Every std::shared_ptr copy and destruction is a locked read-modify-write
+ * on the control block, and when many threads copy one object they all
+ * fight over that cache line. Most copies, though, happen on the thread
+ * that created the object. biased_ptr<T> splits the count in two (Choi,
+ * Shull & Torrellas, "Biased Reference Counting", PACT 2018):
+ *
+ *   - the creating thread (the owner) counts with plain increments
+ *   - every other thread uses a separate atomic count
+ *   - the object dies when the sum reaches zero
+ *
+ *   auto w = smartptrs::make_biased<Widget>(1, "w");  // this thread owns it
+ *   auto copy = w;                                      // plain ++
+ *   std::thread t([w] { auto c = w; });               // atomic on t
+ *
+ * HOW IT WORKS:
+ *   - the shared count may go negative: another thread dropping a copy that
+ *     the owner counted. The first time it does, that thread queues the
+ *     object on the owner's list; the owner drains its queue on its next
+ *     make_biased or release (or biased_merge_queued()), folding its count
+ *     into the shared one ("merging"). From then on all threads count
+ *     atomically and the object is freed normally
+ *   - the owner also merges when its own count reaches zero, and merges
+ *     everything it still owns when it exits, so an object never waits on
+ *     a thread that is gone
+ *   - per-thread records (queue + owned list) are recycled when a thread
+ *     exits, like hazard.hpp's slots; they are never freed
+ *
+ * RULES:
+ *   - Same thread-safety contract as shared_ptr: one biased_ptr instance
+ *     is not safe to modify from two threads, distinct copies are
+ *   - An owner that stops calling make_biased, releasing or
+ *     biased_merge_queued() delays freeing of objects other threads let go
+ *     of, until it exits
+ *   - No weak pointers and no aliasing constructor
+ ******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace smartptrs {
+
+namespace detail {
+
+class biased_control_block;
+
+// One per thread that has created a biased object
+struct alignas(64) bias_owner {
+    std::atomic<biased_control_block*> queued{nullptr}; // pushed by other threads
+    std::atomic<bool> inUse{true};
+    bias_owner* next = nullptr;                         // global record list
+    biased_control_block* owned = nullptr;              // still biased; owner thread only
+};
+
+class biased_control_block {
+public:
+    void addRef() noexcept {
+        if (ownedHere()) ++biasedCount_;
+        else shared_.fetch_add(kOne, std::memory_order_relaxed);
+    }
+
+    void release() noexcept {
+        if (ownedHere()) {
+            bias_owner* home = home_;
+            if (--biasedCount_ == 0) mergeBias(); // may destroy this
+            if (home->queued.load(std::memory_order_relaxed)) drain(*home, true);
+            return;
+        }
+        // One RMW both drops the reference and, if that leaves an unmerged
+        // count negative (a reference the owner counted went away here),
+        // flags the object queued: an owner merging in between then sees
+        // kQueued and leaves the free to the drain. Only this RMW's result
+        // decides what happens next
+        long v = shared_.load(std::memory_order_relaxed);
+        long next;
+        do {
+            next = v - kOne;
+            if (!(v & (kMerged | kQueued)) && count(next) < 0) next |= kQueued;
+        } while (!shared_.compare_exchange_weak(v, next, std::memory_order_acq_rel,
+                                                std::memory_order_relaxed));
+        if (v & kQueued) return; // the drain decides
+        if (next & kQueued) enqueue(); // flagged it: hand it to the owner once
+        else if ((next & kMerged) && count(next) == 0) destroy();
+    }
+
+    // True if the calling thread counts this object non-atomically
+    bool biasedHere() const noexcept { return ownedHere(); }
+
+    // Drains the calling thread's queue; returns the objects merged
+    static std::size_t mergeQueued() noexcept {
+        bias_owner* me = currentOwner();
+        return me ? drain(*me, true) : 0;
+    }
+
+protected:
+    biased_control_block() {
+        bias_owner* me = ownerForNewObject();
+        if (!me) { // thread already exiting: start out merged
+            shared_.store(kOne | kMerged, std::memory_order_relaxed);
+            return;
+        }
+        home_ = me;
+        biased_ = true;
+        biasedCount_ = 1;
+        nextOwned_ = me->owned;
+        if (nextOwned_) nextOwned_->prevOwned_ = this;
+        me->owned = this;
+        if (me->queued.load(std::memory_order_relaxed)) drain(*me, true);
+    }
+    // Only reached still biased if the object's constructor threw
+    virtual ~biased_control_block() {
+        if (biased_) unlinkOwned();
+    }
+    virtual void destroy() noexcept = 0; // destroys the object and the block
+
+private:
+    // shared_ holds (count << 2) | flags; the count may be negative
+    static constexpr long kMerged = 1; // owner's count folded in; owner counts atomically too
+    static constexpr long kQueued = 2; // on the owner's queue: the drain frees it
+    static constexpr long kOne = 4;
+    static constexpr long count(long v) noexcept { return v >> 2; }
+
+    bool ownedHere() const noexcept { return home_ && home_ == currentOwner() && biased_; }
+
+    // Owner only: fold the biased count into the shared one
+    void mergeBias() noexcept {
+        unlinkOwned();
+        biased_ = false;
+        const long n = std::exchange(biasedCount_, 0);
+        const long old = shared_.fetch_add(n * kOne + kMerged, std::memory_order_acq_rel);
+        if (count(old) + n == 0 && !(old & kQueued)) destroy();
+    }
+
+    void unlinkOwned() noexcept {
+        if (prevOwned_) prevOwned_->nextOwned_ = nextOwned_;
+        else home_->owned = nextOwned_;
+        if (nextOwned_) nextOwned_->prevOwned_ = prevOwned_;
+    }
+
+    void enqueue() noexcept {
+        bias_owner& r = *home_;
+        biased_control_block* head = r.queued.load(std::memory_order_relaxed);
+        do {
+            nextQueued_ = head;
+        } while (!r.queued.compare_exchange_weak(head, this, std::memory_order_seq_cst,
+                                                 std::memory_order_relaxed));
+        // Pairs with the exiting owner's inUse store: either its last drain
+        // sees this object or we see the record idle and drain it ourselves
+        if (!r.inUse.load(std::memory_order_seq_cst)) drain(r, false);
+    }
+
+    // Handles one queued object; asOwner if the caller owns its record.
+    // Returns false if the object was pushed back for the record's owner
+    bool drainOne(bias_owner& r, bool asOwner) noexcept {
+        if (asOwner && biased_) mergeBias(); // queued: never frees here
+        else if (!asOwner && !(shared_.load(std::memory_order_acquire) & kMerged)) {
+            // Belongs to a thread that took over the record: give it back
+            biased_control_block* head = r.queued.load(std::memory_order_relaxed);
+            do {
+                nextQueued_ = head;
+            } while (!r.queued.compare_exchange_weak(head, this, std::memory_order_seq_cst,
+                                                     std::memory_order_relaxed));
+            return false;
+        }
+        const long old = shared_.fetch_and(~kQueued, std::memory_order_acq_rel);
+        if ((old & kMerged) && count(old) == 0) destroy();
+        return true;
+    }
+
+    static std::size_t drain(bias_owner& r, bool asOwner) noexcept {
+        std::size_t n = 0;
+        bool gaveBack;
+        do {
+            gaveBack = false;
+            biased_control_block* list = r.queued.exchange(nullptr, std::memory_order_seq_cst);
+            while (list) {
+                biased_control_block* b = list;
+                list = b->nextQueued_;
+                gaveBack |= !b->drainOne(r, asOwner);
+                ++n;
+            }
+            // Like enqueue: the owner we gave objects back to may have gone
+            // idle (merging them) and run its last drain before they landed
+        } while (gaveBack && !r.inUse.load(std::memory_order_seq_cst));
+        return n;
+    }
+
+    // The calling thread's record, or null before its first make_biased
+    static bias_owner*& currentOwnerSlot() noexcept {
+        static thread_local bias_owner* current = nullptr;
+        return current;
+    }
+    static bias_owner* currentOwner() noexcept { return currentOwnerSlot(); }
+
+    struct ThreadState {
+        bias_owner* record = acquireRecord();
+
+        ThreadState() { currentOwnerSlot() = record; }
+        ~ThreadState() {
+            drain(*record, true);
+            while (record->owned) record->owned->mergeBias();
+            currentOwnerSlot() = nullptr;
+            exited() = true;
+            record->inUse.store(false, std::memory_order_seq_cst);
+            drain(*record, false);
+        }
+    };
+
+    static bool& exited() noexcept {
+        static thread_local bool done = false;
+        return done;
+    }
+
+    static bias_owner* ownerForNewObject() {
+        if (bias_owner* me = currentOwner()) return me;
+        if (exited()) return nullptr;
+        static thread_local ThreadState state;
+        return state.record;
+    }
+
+    static std::atomic<bias_owner*>& records() noexcept {
+        // Never destroyed: threads may exit during static destruction
+        static std::atomic<bias_owner*>* head = new std::atomic<bias_owner*>(nullptr);
+        return *head;
+    }
+
+    static bias_owner* acquireRecord() {
+        std::atomic<bias_owner*>& head = records();
+        for (bias_owner* r = head.load(std::memory_order_acquire); r; r = r->next) {
+            bool idle = false;
+            if (!r->inUse.load(std::memory_order_relaxed) &&
+                r->inUse.compare_exchange_strong(idle, true, std::memory_order_acquire)) {
+                return r;
+            }
+        }
+        auto* fresh = new bias_owner;
+        bias_owner* first = head.load(std::memory_order_relaxed);
+        do {
+            fresh->next = first;
+        } while (!head.compare_exchange_weak(first, fresh, std::memory_order_release,
+                                             std::memory_order_relaxed));
+        return fresh;
+    }
+
+    bias_owner* home_ = nullptr;     // creating thread's record; fixed
+    bool biased_ = false;            // owner still counts plainly; owner thread only
+    long biasedCount_ = 0;           // owner thread only
+    std::atomic<long> shared_{0};
+    biased_control_block* prevOwned_ = nullptr; // home_->owned list, owner thread only
+    biased_control_block* nextOwned_ = nullptr;
+    biased_control_block* nextQueued_ = nullptr;
+};
+
+// Object and counts in one allocation (make_biased)
+template<typename T>
+class biased_inplace_block final : public biased_control_block {
+public:
+    template<typename... Args>
+    explicit biased_inplace_block(Args&&... args) {
+        ::new (static_cast<void*>(&storage_)) T(std::forward<Args>(args)...);
+    }
+    T* object() noexcept { return std::launder(reinterpret_cast<T*>(&storage_)); }
+
+private:
+    void destroy() noexcept override {
+        object()->~T();
+        delete this;
+    }
+    alignas(T) unsigned char storage_[sizeof(T)];
+};
+
+// Adopts a separately allocated object
+template<typename T, typename Deleter>
+class biased_pointer_block final : public biased_control_block {
+public:
+    biased_pointer_block(T* p, Deleter d) : ptr_(p), deleter_(std::move(d)) {}
+
+private:
+    void destroy() noexcept override {
+        deleter_(ptr_);
+        delete this;
+    }
+    T* ptr_;
+    Deleter deleter_;
+};
+
+} // namespace detail
+
+template<typename T>
+class biased_ptr {
+public:
+    using element_type = T;
+
+    constexpr biased_ptr() noexcept = default;
+    constexpr biased_ptr(std::nullptr_t) noexcept {}
+
+    template<typename U, typename Deleter = std::default_delete<U>,
+             typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    explicit biased_ptr(U* p, Deleter d = Deleter()) {
+        // Like shared_ptr: if allocating the block throws, p is deleted
+        std::unique_ptr<U, Deleter> guard(p, d);
+        block_ = new detail::biased_pointer_block<U, Deleter>(p, std::move(d));
+        guard.release();
+        ptr_ = p;
+    }
+
+    template<typename U, typename Deleter,
+             typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    biased_ptr(std::unique_ptr<U, Deleter>&& owner) : biased_ptr(owner.get(), owner.get_deleter()) {
+        owner.release();
+    }
+
+    biased_ptr(const biased_ptr& other) noexcept : ptr_(other.ptr_), block_(other.block_) {
+        if (block_) block_->addRef();
+    }
+    biased_ptr(biased_ptr&& other) noexcept
+        : ptr_(std::exchange(other.ptr_, nullptr)), block_(std::exchange(other.block_, nullptr)) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    biased_ptr(const biased_ptr<U>& other) noexcept : ptr_(other.ptr_), block_(other.block_) {
+        if (block_) block_->addRef();
+    }
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    biased_ptr(biased_ptr<U>&& other) noexcept
+        : ptr_(std::exchange(other.ptr_, nullptr)), block_(std::exchange(other.block_, nullptr)) {}
+
+    ~biased_ptr() { if (block_) block_->release(); }
+
+    biased_ptr& operator=(const biased_ptr& other) noexcept {
+        biased_ptr(other).swap(*this);
+        return *this;
+    }
+    biased_ptr& operator=(biased_ptr&& other) noexcept {
+        biased_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept { biased_ptr().swap(*this); }
+    void swap(biased_ptr& other) noexcept {
+        std::swap(ptr_, other.ptr_);
+        std::swap(block_, other.block_);
+    }
+
+    T* get() const noexcept { return ptr_; }
+    T& operator*() const noexcept { return *ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    // True if copies made on this thread use the non-atomic count
+    bool biased() const noexcept { return block_ && block_->biasedHere(); }
+
+private:
+    template<typename U> friend class biased_ptr;
+    template<typename U, typename... Args>
+    friend biased_ptr<U> make_biased(Args&&... args);
+
+    struct adopt_block_t {};
+    biased_ptr(adopt_block_t, T* p, detail::biased_control_block* block) noexcept
+        : ptr_(p), block_(block) {}
+
+    T* ptr_ = nullptr;
+    detail::biased_control_block* block_ = nullptr;
+};
+
+// Single allocation for object + counts, like make_shared; the calling
+// thread becomes the owner
+template<typename T, typename... Args>
+biased_ptr<T> make_biased(Args&&... args) {
+    auto* block = new detail::biased_inplace_block<T>(std::forward<Args>(args)...);
+    return biased_ptr<T>(typename biased_ptr<T>::adopt_block_t{}, block->object(), block);
+}
+
+// Merges the objects other threads queued for the calling thread, freeing
+// those nobody holds any more; returns how many were queued. Owners that
+// go idle for long stretches can call this instead of waiting for their
+// next make_biased or release
+inline std::size_t biased_merge_queued() noexcept { return detail::biased_control_block::mergeQueued(); }
+
+template<typename T, typename U>
+bool operator==(const biased_ptr<T>& a, const biased_ptr<U>& b) noexcept { return a.get() == b.get(); }
+template<typename T, typename U>
+bool operator!=(const biased_ptr<T>& a, const biased_ptr<U>& b) noexcept { return !(a == b); }
+template<typename T>
+bool operator==(const biased_ptr<T>& a, std::nullptr_t) noexcept { return !a; }
+template<typename T>
+bool operator!=(const biased_ptr<T>& a, std::nullptr_t) noexcept { return static_cast<bool>(a); }
+
+} // namespace smartptrs
@@ -0,0 +1,208 @@
+/*******************************************************************************
+ * borrowed_ptr.hpp
+ * Non-owning pointer parameter that never touches a reference count
+ *
+ * "Pass by const shared_ptr&" avoids the count but ties every signature to
+ * one owner type, and it gets lost as soon as the pointer is captured by a
+ * lambda or stored in a task. borrowed_ptr<T> is a one-word vocabulary type
+ * for "use, don't own": it converts implicitly from any of the project's
+ * owning pointers, so one signature serves them all, and copying it is a
+ * plain pointer copy:
+ *
+ *   void draw(smartptrs::borrowed_ptr<const Widget> w);
+ *   draw(sharedWidget);         // shared_ptr<Widget>: no atomic increment
+ *   draw(uniqueWidget);         // unique_ptr<Widget>
+ *   draw(intrusiveWidget);      // intrusive_ptr, local_shared_ptr, gc_ptr...
+ *   pool.submit([w = smartptrs::borrowed_ptr<Widget>(shared)] { w->greet(); });
+ *
+ * RULES:
+ *   - The owner must outlive every borrow. A borrow is for the duration of
+ *     a call chain or of tasks the owner's scope waits for (join, wait());
+ *     anything that may outlive the owner needs a real shared_ptr copy.
+ *   - Debug builds (no NDEBUG) check this on every dereference and when a
+ *     borrow is destroyed or reassigned:
+ *       shared_ptr owners   a weak_ptr to the control block must not be
+ *                           expired (touches the weak count: debug only)
+ *       unique_ptr owners   the unique_ptr must still hold the object, which
+ *                           catches reset(), reassignment and moving it away
+ *                           while borrowed (the owner itself must be alive:
+ *                           a destroyed one is left to ASan)
+ *     Borrows from raw pointers and the other owners are unchecked.
+ *   - Borrowing from a temporary owner does not compile, since
+ *     `borrowed_ptr<T> w = make_shared<T>();` dangles at once. That also
+ *     rejects the safe draw(makeWidget()): name the owner first.
+ *   - Release builds store only the pointer (static_assert below).
+ *   - observer_ptr<T> is the same type, for readers used to the Library
+ *     Fundamentals TS name.
+ ******************************************************************************/
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace smartptrs {
+
+template<typename T> class borrowed_ptr;
+
+namespace detail {
+
+template<typename P, typename = void>
+struct owner_element {};
+
+// Any owning pointer with a get() returning a raw pointer
+template<typename P>
+struct owner_element<P, std::void_t<decltype(std::declval<const P&>().get())>> {
+    using type = std::remove_pointer_t<decltype(std::declval<const P&>().get())>;
+    static constexpr bool value = std::is_pointer_v<decltype(std::declval<const P&>().get())>;
+};
+
+template<typename P>
+struct is_borrowed : std::false_type {};
+template<typename U>
+struct is_borrowed<borrowed_ptr<U>> : std::true_type {};
+
+template<typename P, typename T, typename = void>
+struct borrowable_from : std::false_type {};
+template<typename P, typename T>
+struct borrowable_from<P, T, std::void_t<typename owner_element<P>::type>>
+    : std::bool_constant<owner_element<P>::value && !is_borrowed<P>::value &&
+                         std::is_convertible_v<typename owner_element<P>::type*, T*>> {};
+
+#ifndef NDEBUG
+// What a debug borrow remembers about its owner
+struct borrow_check {
+    enum class kind { unchecked, shared, unique };
+    kind how = kind::unchecked;
+    std::weak_ptr<const void> weak;                       // shared
+    const void* owner = nullptr;                          // unique: the unique_ptr
+    const void* expected = nullptr;                       // unique: its get() when borrowed
+    bool (*holds)(const void* owner, const void* expected) noexcept = nullptr;
+
+    bool ownerAlive() const noexcept {
+        switch (how) {
+        case kind::shared: return !weak.expired();
+        case kind::unique: return holds(owner, expected);
+        default: return true;
+        }
+    }
+};
+
+template<typename U, typename D>
+bool uniqueHolds(const void* owner, const void* expected) noexcept {
+    return static_cast<const void*>(static_cast<const std::unique_ptr<U, D>*>(owner)->get()) == expected;
+}
+#endif
+
+} // namespace detail
+
+template<typename T>
+class borrowed_ptr {
+public:
+    using element_type = T;
+
+    constexpr borrowed_ptr() noexcept = default;
+    constexpr borrowed_ptr(std::nullptr_t) noexcept {}
+
+    // Raw pointers are explicit: nothing says who owns them
+    explicit borrowed_ptr(T* p) noexcept : ptr_(p) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    borrowed_ptr(const std::shared_ptr<U>& owner) noexcept : ptr_(owner.get()) {
+#ifndef NDEBUG
+        if (owner) {
+            check_.how = detail::borrow_check::kind::shared;
+            check_.weak = owner;
+        }
+#endif
+    }
+
+    template<typename U, typename D, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    borrowed_ptr(const std::unique_ptr<U, D>& owner) noexcept : ptr_(owner.get()) {
+#ifndef NDEBUG
+        if (owner) {
+            check_.how = detail::borrow_check::kind::unique;
+            check_.owner = &owner;
+            check_.expected = owner.get();
+            check_.holds = &detail::uniqueHolds<U, D>;
+        }
+#endif
+    }
+
+    // intrusive_ptr, local_shared_ptr, gc_ptr and anything else with get()
+    template<typename P, typename = std::enable_if_t<detail::borrowable_from<P, T>::value>>
+    borrowed_ptr(const P& owner) noexcept : ptr_(owner.get()) {}
+
+    // A temporary owner dies at the end of the full-expression, leaving the
+    // borrow dangling: name the owner first
+    template<typename P, typename = std::enable_if_t<!std::is_lvalue_reference_v<P> &&
+                                                      detail::borrowable_from<std::remove_cv_t<P>, T>::value>>
+    borrowed_ptr(P&& owner) = delete;
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    borrowed_ptr(const borrowed_ptr<U>& other) noexcept : ptr_(other.ptr_) {
+#ifndef NDEBUG
+        check_ = other.check_;
+#endif
+    }
+
+    borrowed_ptr(const borrowed_ptr&) noexcept = default;
+
+#ifdef NDEBUG
+    // Trivial, so borrows are passed and returned in a register
+    borrowed_ptr& operator=(const borrowed_ptr&) noexcept = default;
+    ~borrowed_ptr() = default;
+#else
+    borrowed_ptr& operator=(const borrowed_ptr& other) noexcept {
+        verify();
+        ptr_ = other.ptr_;
+        check_ = other.check_;
+        return *this;
+    }
+
+    ~borrowed_ptr() { verify(); }
+#endif
+
+    T* get() const noexcept {
+        verify();
+        return ptr_;
+    }
+    T& operator*() const noexcept { return *get(); }
+    T* operator->() const noexcept { return get(); }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+private:
+    template<typename U> friend class borrowed_ptr;
+
+    void verify() const noexcept {
+#ifndef NDEBUG
+        assert(check_.ownerAlive() && "borrowed_ptr outlived its owner");
+#endif
+    }
+
+    T* ptr_ = nullptr;
+#ifndef NDEBUG
+    detail::borrow_check check_;
+#endif
+};
+
+#ifdef NDEBUG
+static_assert(sizeof(borrowed_ptr<int>) == sizeof(int*), "borrowed_ptr must stay one word");
+static_assert(std::is_trivially_copyable_v<borrowed_ptr<int>>, "borrowed_ptr must pass in a register");
+#endif
+
+template<typename T>
+using observer_ptr = borrowed_ptr<T>;
+
+template<typename T, typename U>
+bool operator==(const borrowed_ptr<T>& a, const borrowed_ptr<U>& b) noexcept { return a.get() == b.get(); }
+template<typename T, typename U>
+bool operator!=(const borrowed_ptr<T>& a, const borrowed_ptr<U>& b) noexcept { return a.get() != b.get(); }
+template<typename T>
+bool operator==(const borrowed_ptr<T>& a, std::nullptr_t) noexcept { return !a; }
+template<typename T>
+bool operator!=(const borrowed_ptr<T>& a, std::nullptr_t) noexcept { return static_cast<bool>(a); }
+
+} // namespace smartptrs
@@ -0,0 +1,308 @@
+/*******************************************************************************
+ * cache_snapshot.hpp
+ * Saving a ResourceCache's live entries and warm-starting from the saved
+ * file through a read-only mapping (POSIX)
+ *
+ * A cold process rebuilds every resource on first use. A snapshot stores the
+ * encoded bytes of what was live; the next run maps the file and decodes an
+ * entry only when that key is first asked for:
+ *
+ *   // at shutdown (or periodically)
+ *   smartptrs::save_snapshot(cache, "textures.snap",
+ *       [](const Texture& t, std::string& out) { out.append(t.bytes()); });
+ *
+ *   // at startup: one open + mmap + index check, nothing decoded yet
+ *   auto snap = smartptrs::warm_start(cache, "textures.snap",
+ *       [](std::string_view key, std::string_view bytes) {
+ *           return std::make_shared<Texture>(key, bytes);
+ *       });
+ *   auto t = cache.getOrCreate("stone", loadTexture); // decoded, loadTexture not called
+ *
+ * FILE FORMAT (host byte order; written and read on the same architecture):
+ *   snapshot_header                     magic, version, entry count, sizes
+ *   snapshot_entry[count]               sorted by FNV-1a hash of the key
+ *   key and value bytes                 referenced by the entries
+ *   Every offset is a 32-bit offset from the start of the file, so the
+ *   mapping can live at any address and a file is limited to 4 GiB.
+ *
+ * DETAILS:
+ *   - cache_snapshot::find(key) binary-searches the mapped index and
+ *     returns a string_view into the mapping: no allocation, no copy.
+ *     Opening validates the header and every entry's bounds once, so a
+ *     truncated or foreign file throws std::runtime_error instead of
+ *     being read out of range; I/O errors throw std::system_error
+ *   - warm_start installs the snapshot as the cache's miss source: the first
+ *     miss on a key the snapshot has calls decode instead of the factory
+ *     (counted in CacheStats::sourced); other keys still go to the factory.
+ *     Each entry is served once (cache_snapshot::take), so a key that is
+ *     evicted or expires later is rebuilt by the factory, not re-decoded
+ *     from the old bytes. The source keeps the mapping alive until it is
+ *     replaced (setMissSource(nullptr) drops it once warmed, before the
+ *     cache is shared); decode must copy what it keeps, the views die with
+ *     the mapping
+ *   - save_snapshot writes "<path>.tmp", fsyncs it, renames it over path
+ *     and fsyncs the directory, so neither a crash mid-save nor a power
+ *     loss after it leaves a torn snapshot. Entries are the cache's live
+ *     objects at the time of the call (forEachLive)
+ ******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "file_writer.hpp"
+#include "resource_cache.hpp"
+#include "unique_resource.hpp"
+
+namespace smartptrs {
+
+struct snapshot_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t count;
+    std::uint64_t fileSize;
+    std::uint32_t indexOffset;
+    std::uint32_t reserved;
+};
+
+struct snapshot_entry {
+    std::uint64_t hash;
+    std::uint32_t keyOffset;
+    std::uint32_t keyLength;
+    std::uint32_t valueOffset;
+    std::uint32_t valueLength;
+};
+
+static_assert(sizeof(snapshot_header) == 32 && sizeof(snapshot_entry) == 24, "snapshot layout changed");
+
+namespace detail {
+
+inline constexpr char kSnapshotMagic[8] = {'S', 'P', 'C', 'A', 'C', 'H', 'E', '\0'};
+inline constexpr std::uint32_t kSnapshotVersion = 1;
+
+// FNV-1a: stable across runs and standard libraries, unlike std::hash
+inline std::uint64_t snapshotHash(std::string_view key) noexcept {
+    std::uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : key) h = (h ^ c) * 1099511628211ull;
+    return h;
+}
+
+[[noreturn]] inline void throwCorrupt(const char* what) {
+    throw std::runtime_error(std::string("cache_snapshot: ") + what);
+}
+
+} // namespace detail
+
+// Collects key/value pairs and writes them as one snapshot file
+class snapshot_builder {
+public:
+    void add(std::string_view key, std::string_view value) {
+        snapshot_entry e{detail::snapshotHash(key), offset(key.size()), std::uint32_t(key.size()), 0, 0};
+        data_.append(key);
+        e.valueOffset = offset(value.size());
+        e.valueLength = std::uint32_t(value.size());
+        data_.append(value);
+        entries_.push_back(e);
+    }
+
+    std::size_t size() const noexcept { return entries_.size(); }
+
+    // Writes and fsyncs "<path>.tmp", renames it over path, then fsyncs the
+    // directory so the rename itself is durable
+    void write(const char* path) {
+        std::stable_sort(entries_.begin(), entries_.end(),
+                         [](const snapshot_entry& a, const snapshot_entry& b) { return a.hash < b.hash; });
+        const std::uint64_t base = sizeof(snapshot_header) + entries_.size() * sizeof(snapshot_entry);
+        const std::uint64_t total = base + data_.size();
+        if (total > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("cache_snapshot: snapshot larger than 4 GiB");
+
+        snapshot_header h{};
+        std::memcpy(h.magic, detail::kSnapshotMagic, sizeof h.magic);
+        h.version = detail::kSnapshotVersion;
+        h.count = std::uint32_t(entries_.size());
+        h.fileSize = total;
+        h.indexOffset = sizeof(snapshot_header);
+        for (snapshot_entry& e : entries_) { // data-relative -> file-relative
+            e.keyOffset += std::uint32_t(base);
+            e.valueOffset += std::uint32_t(base);
+        }
+
+        const std::string tmp = std::string(path) + ".tmp";
+        {
+            buffered_writer out(tmp.c_str());
+            out.write(std::string_view(reinterpret_cast<const char*>(&h), sizeof h));
+            if (!entries_.empty()) {
+                out.write(std::string_view(reinterpret_cast<const char*>(entries_.data()),
+                                           entries_.size() * sizeof(snapshot_entry)));
+                out.write(data_);
+            }
+            out.flush();
+            if (::fsync(out.fd()) != 0) detail::throwErrno("fsync");
+            out.close();
+        }
+        if (std::rename(tmp.c_str(), path) != 0) detail::throwErrno("rename");
+        syncParent(path);
+        entries_.clear();
+        data_.clear();
+    }
+
+private:
+    static void syncParent(const char* path) {
+        const std::string_view p(path);
+        const std::size_t slash = p.rfind('/');
+        const std::string dir = slash == std::string_view::npos ? std::string(".")
+                                                                : std::string(p.substr(0, slash ? slash : 1));
+        unique_fd fd(::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        if (!fd) detail::throwErrno("open");
+        if (::fsync(fd.get()) != 0) detail::throwErrno("fsync");
+    }
+
+    std::uint32_t offset(std::size_t adding) const {
+        if (data_.size() + adding > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("cache_snapshot: snapshot larger than 4 GiB");
+        return std::uint32_t(data_.size());
+    }
+
+    std::vector<snapshot_entry> entries_;
+    std::string data_;
+};
+
+// Read-only mapping of a snapshot file; find() and take() are thread-safe
+class cache_snapshot {
+public:
+    explicit cache_snapshot(const char* path) {
+        unique_fd fd(::open(path, O_RDONLY | O_CLOEXEC));
+        if (!fd) detail::throwErrno("open");
+        struct stat st;
+        if (::fstat(fd.get(), &st) != 0) detail::throwErrno("fstat");
+        size_ = std::size_t(st.st_size);
+        if (size_ < sizeof(snapshot_header)) detail::throwCorrupt("truncated header");
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+        if (p == MAP_FAILED) detail::throwErrno("mmap");
+        map_ = static_cast<const char*>(p);
+        try {
+            validate();
+            taken_.reset(new std::atomic<bool>[count_]());
+        } catch (...) {
+            ::munmap(const_cast<char*>(map_), size_);
+            throw;
+        }
+    } // the mapping outlives fd
+
+    cache_snapshot(const cache_snapshot&) = delete;
+    cache_snapshot& operator=(const cache_snapshot&) = delete;
+    ~cache_snapshot() { ::munmap(const_cast<char*>(map_), size_); }
+
+    std::size_t size() const noexcept { return count_; }
+    std::size_t fileSize() const noexcept { return size_; }
+
+    // The stored bytes for key, viewing the mapping
+    std::optional<std::string_view> find(std::string_view key) const noexcept {
+        const snapshot_entry* e = lookup(key);
+        if (!e) return std::nullopt;
+        return std::string_view(map_ + e->valueOffset, e->valueLength);
+    }
+
+    // Like find, but each entry is handed out once: later calls for the same
+    // key (from any thread) return nullopt
+    std::optional<std::string_view> take(std::string_view key) const noexcept {
+        const snapshot_entry* e = lookup(key);
+        if (!e || taken_[std::size_t(e - index_)].exchange(true, std::memory_order_relaxed)) return std::nullopt;
+        return std::string_view(map_ + e->valueOffset, e->valueLength);
+    }
+
+    // Calls fn(key, value) for every entry, in index order
+    template<typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const snapshot_entry* e = index_; e != index_ + count_; ++e)
+            fn(std::string_view(map_ + e->keyOffset, e->keyLength),
+               std::string_view(map_ + e->valueOffset, e->valueLength));
+    }
+
+private:
+    const snapshot_entry* lookup(std::string_view key) const noexcept {
+        const std::uint64_t h = detail::snapshotHash(key);
+        const snapshot_entry* end = index_ + count_;
+        const snapshot_entry* e = std::lower_bound(
+            index_, end, h, [](const snapshot_entry& x, std::uint64_t v) { return x.hash < v; });
+        for (; e != end && e->hash == h; ++e) {
+            if (std::string_view(map_ + e->keyOffset, e->keyLength) == key) return e;
+        }
+        return nullptr;
+    }
+
+    void validate() {
+        const auto& h = *reinterpret_cast<const snapshot_header*>(map_);
+        if (std::memcmp(h.magic, detail::kSnapshotMagic, sizeof h.magic) != 0) detail::throwCorrupt("bad magic");
+        if (h.version != detail::kSnapshotVersion) detail::throwCorrupt("unsupported version");
+        if (h.fileSize != size_) detail::throwCorrupt("size mismatch");
+        if (h.indexOffset % alignof(snapshot_entry) != 0 ||
+            std::uint64_t(h.indexOffset) + std::uint64_t(h.count) * sizeof(snapshot_entry) > size_)
+            detail::throwCorrupt("index out of range");
+        index_ = reinterpret_cast<const snapshot_entry*>(map_ + h.indexOffset);
+        count_ = h.count;
+        for (std::size_t i = 0; i < count_; ++i) {
+            const snapshot_entry& e = index_[i];
+            if (std::uint64_t(e.keyOffset) + e.keyLength > size_ ||
+                std::uint64_t(e.valueOffset) + e.valueLength > size_)
+                detail::throwCorrupt("entry out of range");
+            if (i > 0 && index_[i - 1].hash > e.hash) detail::throwCorrupt("index not sorted");
+        }
+    }
+
+    const char* map_ = nullptr;
+    std::size_t size_ = 0;
+    const snapshot_entry* index_ = nullptr;
+    std::size_t count_ = 0;
+    std::unique_ptr<std::atomic<bool>[]> taken_; // per entry: served by take()
+};
+
+// Writes cache's live entries to path; encode(const T&, std::string& out)
+// appends an object's bytes. Returns the number of entries written
+template<typename T, typename Mode, typename Encode>
+std::size_t save_snapshot(const ResourceCache<T, Mode>& cache, const char* path, Encode encode) {
+    snapshot_builder builder;
+    std::string bytes;
+    cache.forEachLive([&](std::string_view key, const std::shared_ptr<T>& object) {
+        bytes.clear();
+        encode(static_cast<const T&>(*object), bytes);
+        builder.add(key, bytes);
+    });
+    const std::size_t n = builder.size();
+    builder.write(path);
+    return n;
+}
+
+// Maps path and makes it cache's miss source: decode(key, bytes) ->
+// shared_ptr<T> builds an object the first time its key is asked for.
+// Call before sharing the cache between threads
+template<typename T, typename Mode, typename Decode>
+std::shared_ptr<const cache_snapshot> warm_start(ResourceCache<T, Mode>& cache, const char* path, Decode decode) {
+    auto snap = std::make_shared<const cache_snapshot>(path);
+    cache.setMissSource([snap, decode = std::move(decode)](std::string_view key) -> std::shared_ptr<T> {
+        const std::optional<std::string_view> bytes = snap->take(key);
+        if (!bytes) return nullptr;
+        return decode(key, *bytes);
+    });
+    return snap;
+}
+
+} // namespace smartptrs
@@ -0,0 +1,304 @@
+/*******************************************************************************
+ * deferred_delete.hpp
+ * Deleter adaptor that moves expensive destruction off the calling thread
+ *
+ * Whoever drops the last reference runs the deleter - often a latency-
+ * sensitive request thread that then blocks in fclose()/munmap()/a big
+ * destructor. deferred_deleter<D> instead pushes the pointer onto a
+ * bounded multi-producer ring, and a background drain thread runs D:
+ *
+ *   std::unique_ptr<FILE, smartptrs::deferred_deleter<FileCloser>> f(fopen(...));
+ *   std::shared_ptr<Widget> w(new Widget(1), smartptrs::deferred_deleter<>());
+ *   smartptrs::reclamation_queue::global().flush();  // wait for pending closes
+ *
+ * DETAILS:
+ *   - A stateless D keeps deferred_deleter<D> empty, so the unique_ptr stays
+ *     one word and enqueueing doesn't allocate. A stateful D is boxed on the
+ *     heap with its pointer.
+ *   - When the ring is full the deleter runs inline (counted as
+ *     inlineFallbacks): callers never wait for the drain thread.
+ *   - stats() reports current and peak depth and the enqueue-to-destroy
+ *     latency, so the queue can be sized from numbers.
+ *   - The global queue drains everything still queued when it is destroyed at
+ *     exit; deletions after that run inline.
+ *   - A deleter running on the drain thread must not call flush().
+ ******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace smartptrs {
+
+struct reclamation_stats {
+    std::size_t depth = 0;           // queued, not yet destroyed
+    std::size_t maxDepth = 0;
+    std::uint64_t drained = 0;       // destroyed by the drain thread
+    std::uint64_t inlineFallbacks = 0; // ring full: destroyed by the caller
+    std::uint64_t avgLatencyNs = 0;  // enqueue -> destroyed
+    std::uint64_t maxLatencyNs = 0;
+};
+
+class reclamation_queue {
+public:
+    static constexpr std::size_t kDefaultCapacity = 4096;
+
+    // capacity is rounded up to a power of two
+    explicit reclamation_queue(std::size_t capacity = kDefaultCapacity)
+        : mask_(roundUp(capacity) - 1), cells_(mask_ + 1) {
+        for (std::size_t i = 0; i <= mask_; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+        drainer_ = std::thread([this] { drainLoop(); });
+    }
+
+    reclamation_queue(const reclamation_queue&) = delete;
+    reclamation_queue& operator=(const reclamation_queue&) = delete;
+
+    // Destroys everything still queued, then stops the drain thread
+    ~reclamation_queue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        drainer_.join();
+    }
+
+    // Lazily started process-wide queue used by deferred_deleter
+    static reclamation_queue& global() {
+        struct Global : reclamation_queue {
+            ~Global() { globalClosed().store(true, std::memory_order_release); }
+        };
+        static Global queue;
+        return queue;
+    }
+
+    // Queues p on the global queue, or destroys it now once that queue has
+    // been torn down at exit
+    template<typename T, typename Deleter>
+    static void defer(T* p, Deleter& deleter) {
+        if (globalClosed().load(std::memory_order_acquire)) {
+            deleter(p);
+        } else {
+            global().push(p, deleter);
+        }
+    }
+
+    // Queues deleter(p); runs it inline if the ring is full
+    template<typename T, typename Deleter>
+    void push(T* p, Deleter deleter) {
+        if (!p) return;
+        Entry e;
+        if constexpr (std::is_empty_v<Deleter> && std::is_default_constructible_v<Deleter>) {
+            e.run = [](void* ptr, void*) { Deleter()(static_cast<T*>(ptr)); };
+            e.ptr = p;
+        } else {
+            using Box = std::pair<T*, Deleter>;
+            e.run = [](void*, void* box) {
+                std::unique_ptr<Box> b(static_cast<Box*>(box));
+                b->second(b->first);
+            };
+            e.extra = new Box(p, std::move(deleter));
+        }
+        if (!tryPush(e)) {
+            inlineFallbacks_.fetch_add(1, std::memory_order_relaxed);
+            e.run(e.ptr, e.extra);
+        }
+    }
+
+    // Waits until everything queued before the call has been destroyed
+    void flush() {
+        const std::uint64_t target = enqueuePos_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex_);
+        flushWaiters_.fetch_add(1, std::memory_order_seq_cst);
+        flushed_.wait(lock, [&] { return drainedPos_.load(std::memory_order_seq_cst) >= target; });
+        flushWaiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    reclamation_stats stats() const noexcept {
+        reclamation_stats s;
+        const std::uint64_t queued = enqueuePos_.load(std::memory_order_relaxed);
+        const std::uint64_t done = drainedPos_.load(std::memory_order_relaxed);
+        s.depth = queued > done ? std::size_t(queued - done) : 0;
+        s.maxDepth = maxDepth_.load(std::memory_order_relaxed);
+        s.drained = done;
+        s.inlineFallbacks = inlineFallbacks_.load(std::memory_order_relaxed);
+        s.avgLatencyNs = done ? totalLatencyNs_.load(std::memory_order_relaxed) / done : 0;
+        s.maxLatencyNs = maxLatencyNs_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+private:
+    struct Entry {
+        void (*run)(void* ptr, void* extra) = nullptr;
+        void* ptr = nullptr;
+        void* extra = nullptr;
+        std::int64_t enqueuedNs = 0;
+    };
+
+    // Bounded MPMC ring cell (Vyukov): seq == pos means free for the
+    // producer claiming pos, seq == pos + 1 means published
+    struct alignas(64) Cell {
+        std::atomic<std::uint64_t> seq{0};
+        Entry entry;
+    };
+
+    static std::size_t roundUp(std::size_t n) noexcept {
+        std::size_t p = 2;
+        while (p < n) p *= 2;
+        return p;
+    }
+
+    static std::int64_t nowNs() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static std::atomic<bool>& globalClosed() noexcept {
+        static std::atomic<bool> closed{false}; // trivially destructible: outlives global()
+        return closed;
+    }
+
+    bool tryPush(Entry e) {
+        std::uint64_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            const std::uint64_t seq = cell->seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::int64_t>(seq - pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        e.enqueuedNs = nowNs();
+        cell->entry = e;
+        cell->seq.store(pos + 1, std::memory_order_release);
+
+        std::uint64_t depth = pos + 1 - drainedPos_.load(std::memory_order_relaxed);
+        if (depth > capacity()) depth = capacity(); // drainedPos_ may be stale
+        std::size_t peak = maxDepth_.load(std::memory_order_relaxed);
+        while (depth > peak && !maxDepth_.compare_exchange_weak(peak, std::size_t(depth),
+                                                                std::memory_order_relaxed)) {}
+
+        // Pairs with the drain thread's sleeping_ store + re-check
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_seq_cst)) {
+            { std::lock_guard<std::mutex> lock(mutex_); }
+            wake_.notify_one();
+        }
+        return true;
+    }
+
+    // Single consumer: only the drain thread pops
+    bool tryPop(Entry& out) {
+        const std::uint64_t pos = drainedPos_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & mask_];
+        if (cell.seq.load(std::memory_order_acquire) != pos + 1) return false;
+        out = cell.entry;
+        cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    void drainLoop() {
+        Entry e;
+        for (;;) {
+            while (tryPop(e)) {
+                e.run(e.ptr, e.extra);
+                const auto latency = std::uint64_t(nowNs() - e.enqueuedNs);
+                totalLatencyNs_.fetch_add(latency, std::memory_order_relaxed);
+                if (latency > maxLatencyNs_.load(std::memory_order_relaxed)) {
+                    maxLatencyNs_.store(latency, std::memory_order_relaxed);
+                }
+                drainedPos_.fetch_add(1, std::memory_order_seq_cst);
+                if (flushWaiters_.load(std::memory_order_seq_cst) != 0) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    flushed_.notify_all();
+                }
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            sleeping_.store(true, std::memory_order_seq_cst);
+            const std::uint64_t pos = drainedPos_.load(std::memory_order_relaxed);
+            if (cells_[pos & mask_].seq.load(std::memory_order_seq_cst) != pos + 1) {
+                // Producers that already claimed a cell will publish and wake us
+                if (stopping_ && enqueuePos_.load(std::memory_order_relaxed) == pos) return;
+                wake_.wait(lock);
+            }
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    const std::size_t mask_;
+    std::vector<Cell> cells_;
+    alignas(64) std::atomic<std::uint64_t> enqueuePos_{0};
+    alignas(64) std::atomic<std::uint64_t> drainedPos_{0};
+    std::atomic<std::size_t> maxDepth_{0};
+    std::atomic<std::uint64_t> inlineFallbacks_{0};
+    std::atomic<std::uint64_t> totalLatencyNs_{0};
+    std::atomic<std::uint64_t> maxLatencyNs_{0};
+    std::atomic<bool> sleeping_{false};
+
+    std::mutex mutex_;
+    std::condition_variable wake_;    // drain thread sleeps here
+    std::condition_variable flushed_; // flush() waits here
+    std::atomic<unsigned> flushWaiters_{0};
+    bool stopping_ = false;           // guarded by mutex_
+    std::thread drainer_;
+};
+
+namespace detail {
+
+// Holds the wrapped deleter without taking space when it is empty
+template<typename D, bool Empty = std::is_empty_v<D> && !std::is_final_v<D>>
+struct deleter_holder : private D {
+    deleter_holder() = default;
+    explicit deleter_holder(D d) : D(std::move(d)) {}
+    D& deleter() noexcept { return *this; }
+};
+
+template<typename D>
+struct deleter_holder<D, false> {
+    deleter_holder() = default;
+    explicit deleter_holder(D d) : d_(std::move(d)) {}
+    D& deleter() noexcept { return d_; }
+    D d_;
+};
+
+} // namespace detail
+
+// Runs D on the global reclamation queue's drain thread
+template<typename D = void>
+class deferred_deleter : private detail::deleter_holder<D> {
+public:
+    deferred_deleter() = default;
+    explicit deferred_deleter(D d) : detail::deleter_holder<D>(std::move(d)) {}
+
+    template<typename T>
+    void operator()(T* p) noexcept { reclamation_queue::defer(p, this->deleter()); }
+};
+
+// deferred_deleter<> deletes with default_delete<T> for whatever T it gets
+template<>
+class deferred_deleter<void> {
+public:
+    template<typename T>
+    void operator()(T* p) const noexcept {
+        std::default_delete<T> d;
+        reclamation_queue::defer(p, d);
+    }
+};
+
+} // namespace smartptrs
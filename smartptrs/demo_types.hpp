@@ -0,0 +1,135 @@
+/*******************************************************************************
+ * demo_types.hpp
+ * The tutorial's demonstration types, parameterized on a trace policy
+ *
+ * smartptr.cpp instantiates these with stream_trace so every construction
+ * and destruction is printed. Benchmarks and load tests instantiate them
+ * with no_trace, which compiles the logging away and leaves the same
+ * layout and lifecycle (see trace.hpp):
+ *
+ *   using Widget      = smartptrs::BasicWidget<smartptrs::stream_trace>;
+ *   using QuietWidget = smartptrs::BasicWidget<smartptrs::no_trace>;
+ *
+ * Widget, the cycle nodes and Component derive from tracked<> so a
+ * -DSMARTPTRS_DIAGNOSTICS build counts them and reports survivors at exit
+ * (see diagnostics.hpp); otherwise the base is empty.
+ ******************************************************************************/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "diagnostics.hpp"
+#include "gc_ptr.hpp"
+#include "trace.hpp"
+
+namespace smartptrs {
+
+template<typename Trace>
+struct BasicWidget : tracked<BasicWidget<Trace>> {
+    int id;
+    std::string name;
+
+    BasicWidget(int i, std::string n = "") : id(i), name(std::move(n)) {
+        if constexpr (Trace::enabled)
+            Trace::log("Widget(", id, ") constructed", name.empty() ? "" : ": ", name);
+    }
+
+    ~BasicWidget() {
+        if constexpr (Trace::enabled)
+            Trace::log("Widget(", id, ") destroyed", name.empty() ? "" : ": ", name);
+    }
+
+    void greet() const {
+        if constexpr (Trace::enabled)
+            Trace::log("Widget(", id, ") says hello", name.empty() ? "" : ": ", name);
+    }
+};
+
+// Cycle demonstration: strong links leak, weak links don't
+template<typename Trace>
+struct BasicNodeShared : tracked<BasicNodeShared<Trace>> {
+    int value;
+    std::shared_ptr<BasicNodeShared> next;
+    BasicNodeShared(int v) : value(v) {
+        if constexpr (Trace::enabled) Trace::log("NodeShared(", value, ") constructed");
+    }
+    ~BasicNodeShared() {
+        if constexpr (Trace::enabled) Trace::log("NodeShared(", value, ") destroyed");
+    }
+    // Owning links, for the diagnostics cycle report
+    template<typename F> void diagEdges(F&& visit) const { visit(next.get()); }
+};
+
+template<typename Trace>
+struct BasicNodeWeak : tracked<BasicNodeWeak<Trace>> {
+    int value;
+    std::weak_ptr<BasicNodeWeak> next; // weak pointer breaks cycle
+    BasicNodeWeak(int v) : value(v) {
+        if constexpr (Trace::enabled) Trace::log("NodeWeak(", value, ") constructed");
+    }
+    ~BasicNodeWeak() {
+        if constexpr (Trace::enabled) Trace::log("NodeWeak(", value, ") destroyed");
+    }
+};
+
+// Arena-scoped graph node (raw links, freed in bulk by the arena)
+template<typename Trace>
+struct BasicArenaNode {
+    int value;
+    BasicArenaNode* next = nullptr;
+    BasicArenaNode(int v) : value(v) {
+        if constexpr (Trace::enabled) Trace::log("ArenaNode(", value, ") constructed");
+    }
+    ~BasicArenaNode() {
+        if constexpr (Trace::enabled) Trace::log("ArenaNode(", value, ") destroyed");
+    }
+};
+
+// Cycle-collected graph node (gc_ptr links, cycles freed by gc_heap::collect)
+template<typename Trace>
+struct BasicGcNode : gc_object {
+    int value;
+    gc_ptr<BasicGcNode> next;
+    BasicGcNode(int v) : value(v) {
+        if constexpr (Trace::enabled) Trace::log("GcNode(", value, ") constructed");
+    }
+    ~BasicGcNode() override {
+        if constexpr (Trace::enabled) Trace::log("GcNode(", value, ") destroyed");
+    }
+    void trace(gc_tracer& t) override { t(next); }
+};
+
+// enable_shared_from_this - get shared_ptr from 'this'
+template<typename Trace>
+struct BasicComponent : std::enable_shared_from_this<BasicComponent<Trace>>,
+                        tracked<BasicComponent<Trace>> {
+    int id;
+    BasicComponent(int i) : id(i) {
+        if constexpr (Trace::enabled) Trace::log("Component(", id, ") created");
+    }
+    ~BasicComponent() {
+        if constexpr (Trace::enabled) Trace::log("Component(", id, ") destroyed");
+    }
+
+    // Can safely return shared_ptr to self
+    std::shared_ptr<BasicComponent> getPtr() { return this->shared_from_this(); }
+};
+
+// Polymorphic deletion through a base pointer
+template<typename Trace>
+struct BasicBase {
+    virtual ~BasicBase() {
+        if constexpr (Trace::enabled) Trace::log("~Base()");
+    }
+};
+
+template<typename Trace>
+struct BasicDerived : BasicBase<Trace> {
+    ~BasicDerived() override {
+        if constexpr (Trace::enabled) Trace::log("~Derived()");
+    }
+};
+
+} // namespace smartptrs
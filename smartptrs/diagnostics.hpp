@@ -0,0 +1,567 @@
+/*******************************************************************************
+ * diagnostics.hpp
+ * Leak and ownership diagnostics, compiled in with -DSMARTPTRS_DIAGNOSTICS
+ *
+ * cycleDemo()'s leak is only visible as missing destructor lines. In a
+ * diagnostics build, types that derive from tracked<T> are counted and
+ * registered while alive, and whatever is still alive at exit is reported
+ * with the factory and call stack that created it:
+ *
+ *   struct Node : smartptrs::tracked<Node> {
+ *       std::shared_ptr<Node> next;
+ *       // optional: lets the report tell cycles from plain leaks
+ *       template<typename F> void diagEdges(F&& visit) const { visit(next.get()); }
+ *   };
+ *
+ *   template<typename T> std::unique_ptr<T> makeNode() {
+ *       smartptrs::alloc_site site("makeNode"); // labels objects built here
+ *       return std::make_unique<T>();
+ *   }
+ *
+ *   smartptrs::diagnostics::live<Node>();       // objects alive right now
+ *   smartptrs::diagnostics::report(std::cerr);  // also printed at exit
+ *
+ * WITHOUT -DSMARTPTRS_DIAGNOSTICS:
+ *   tracked<T> is an empty base (no size, trivial constructors), alloc_site
+ *   does nothing and the queries return zeros, so instrumented types and
+ *   factories cost nothing. The macro must be the same in every translation
+ *   unit of a program.
+ *
+ * WITH IT:
+ *   - live/created/destroyed/peak counts per type live in per-thread
+ *     counter blocks (plain relaxed stores, no shared cache lines); queries
+ *     sum the blocks, including those of exited threads
+ *   - peak is the sum of each thread's own high-water mark: exact when
+ *     objects die on the thread that made them, an upper bound otherwise
+ *   - every object is linked into one of 16 mutex-striped lists with its
+ *     allocation site (the innermost alloc_site) and, where <execinfo.h>
+ *     exists, its first SMARTPTRS_DIAGNOSTICS_STACK_DEPTH (default 16) return
+ *     addresses; building with -rdynamic gives the frames names
+ *   - the exit report groups survivors by type, site and stack, and marks
+ *     those on a cycle of diagEdges() links and those only kept alive by one
+ *   - objects a pool keeps for reuse (diagnostics::setIdle; ObjectPool does
+ *     it) are counted as live but left out of the list: the pool holds
+ *     them on purpose
+ *   - objects with static storage duration created before the first tracked
+ *     object outlive the report and show up in it
+ ******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(SMARTPTRS_DIAGNOSTICS)
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define SMARTPTRS_DIAGNOSTICS_BACKTRACE 1
+#endif
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+#endif
+
+#ifndef SMARTPTRS_DIAGNOSTICS_STACK_DEPTH
+#define SMARTPTRS_DIAGNOSTICS_STACK_DEPTH 16
+#endif
+
+namespace smartptrs {
+
+#if defined(SMARTPTRS_DIAGNOSTICS)
+
+template<typename T> class tracked;
+
+namespace detail {
+
+// Per-object registration, embedded in tracked<T>
+struct diag_record {
+    diag_record* prev = nullptr;
+    diag_record* next = nullptr;
+    const char* site = nullptr;
+    void* stack[SMARTPTRS_DIAGNOSTICS_STACK_DEPTH > 0 ? SMARTPTRS_DIAGNOSTICS_STACK_DEPTH : 1];
+    std::uint16_t type = 0;
+    std::uint8_t depth = 0;
+    mutable std::atomic<bool> idle{false}; // parked in a pool, not leaked
+};
+
+template<typename U>
+const diag_record& recordOf(const tracked<U>& object) noexcept;
+
+template<typename U>
+std::true_type isTracked(const tracked<U>*);
+std::false_type isTracked(const void*);
+
+// Passed to T::diagEdges(); collects the records of tracked children
+struct diag_edge_sink {
+    std::vector<const diag_record*>* out;
+    template<typename U>
+    void operator()(const U* child) const {
+        if (child) out->push_back(&recordOf(*child));
+    }
+};
+
+template<typename T, typename = void>
+struct has_diag_edges : std::false_type {};
+template<typename T>
+struct has_diag_edges<T, std::void_t<decltype(std::declval<const T&>().diagEdges(
+                             std::declval<diag_edge_sink&>()))>> : std::true_type {};
+
+using diag_edges_fn = void (*)(const diag_record&, diag_edge_sink&);
+
+class diag_registry {
+public:
+    static constexpr std::size_t kMaxTypes = 256;
+    static constexpr std::size_t kShards = 16;
+
+    struct Counters {
+        std::atomic<std::uint64_t> created{0};
+        std::atomic<std::uint64_t> destroyed{0};
+        std::atomic<std::int64_t> peak{0};
+    };
+
+    // One per thread, never freed so exited threads still count
+    struct ThreadBlock {
+        Counters types[kMaxTypes];
+    };
+
+    struct TypeInfo {
+        std::string name;
+        diag_edges_fn edges = nullptr;
+    };
+
+    static diag_registry& instance() {
+        // Never destroyed: objects may die during static destruction
+        static diag_registry* r = new diag_registry;
+        return *r;
+    }
+
+    // The last slot collects every type past kMaxTypes - 1
+    std::uint16_t addType(std::string name, diag_edges_fn edges) {
+        std::lock_guard<std::mutex> lock(typesMutex_);
+        if (typeCount_ == kMaxTypes - 1) {
+            types_[typeCount_].name = "(other types)";
+            return std::uint16_t(typeCount_);
+        }
+        types_[typeCount_] = {std::move(name), edges};
+        return std::uint16_t(typeCount_++);
+    }
+
+    void add(diag_record& r) noexcept {
+        Counters& c = threadBlock().types[r.type];
+        const auto net = bump(c.created) - std::int64_t(c.destroyed.load(std::memory_order_relaxed));
+        if (net > c.peak.load(std::memory_order_relaxed)) c.peak.store(net, std::memory_order_relaxed);
+
+        Shard& s = shardOf(&r);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        r.next = s.head;
+        if (s.head) s.head->prev = &r;
+        s.head = &r;
+    }
+
+    void remove(diag_record& r) noexcept {
+        bump(threadBlock().types[r.type].destroyed);
+        Shard& s = shardOf(&r);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (r.prev) r.prev->next = r.next;
+        else s.head = r.next;
+        if (r.next) r.next->prev = r.prev;
+    }
+
+    struct Totals {
+        std::uint64_t created = 0;
+        std::uint64_t destroyed = 0;
+        std::int64_t peak = 0;
+    };
+
+    Totals totals(std::size_t type) {
+        Totals t;
+        std::lock_guard<std::mutex> lock(blocksMutex_);
+        for (const ThreadBlock* b : blocks_) {
+            t.created += b->types[type].created.load(std::memory_order_relaxed);
+            t.destroyed += b->types[type].destroyed.load(std::memory_order_relaxed);
+            t.peak += b->types[type].peak.load(std::memory_order_relaxed);
+        }
+        return t;
+    }
+
+    std::size_t typeCount() {
+        std::lock_guard<std::mutex> lock(typesMutex_);
+        return types_[typeCount_].name.empty() ? typeCount_ : typeCount_ + 1;
+    }
+
+    TypeInfo typeInfo(std::size_t type) {
+        std::lock_guard<std::mutex> lock(typesMutex_);
+        return types_[type];
+    }
+
+    // Calls f(record) for every live object with all shards locked
+    template<typename F>
+    void forEachLive(F&& f) {
+        std::unique_lock<std::mutex> locks[kShards];
+        for (std::size_t i = 0; i < kShards; ++i) locks[i] = std::unique_lock<std::mutex>(shards_[i].mutex);
+        for (Shard& s : shards_) {
+            for (const diag_record* r = s.head; r; r = r->next) f(*r);
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        diag_record* head = nullptr;
+    };
+
+    diag_registry();
+
+    // Single writer per block: load + store instead of a locked RMW
+    static std::int64_t bump(std::atomic<std::uint64_t>& c) noexcept {
+        const std::uint64_t v = c.load(std::memory_order_relaxed) + 1;
+        c.store(v, std::memory_order_relaxed);
+        return std::int64_t(v);
+    }
+
+    Shard& shardOf(const void* p) noexcept {
+        return shards_[(reinterpret_cast<std::uintptr_t>(p) >> 6) % kShards];
+    }
+
+    ThreadBlock& threadBlock() {
+        static thread_local ThreadBlock* block = nullptr; // trivially destructible
+        if (!block) {
+            block = new ThreadBlock;
+            std::lock_guard<std::mutex> lock(blocksMutex_);
+            blocks_.push_back(block);
+        }
+        return *block;
+    }
+
+    Shard shards_[kShards];
+    std::mutex typesMutex_;
+    TypeInfo types_[kMaxTypes];
+    std::size_t typeCount_ = 0;
+    std::mutex blocksMutex_;
+    std::vector<ThreadBlock*> blocks_;
+};
+
+inline const char*& currentSite() noexcept {
+    static thread_local const char* site = nullptr;
+    return site;
+}
+
+inline std::string demangle(const char* name) {
+#if __has_include(<cxxabi.h>)
+    int status = 0;
+    char* readable = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0 && readable) {
+        std::string s(readable);
+        std::free(readable);
+        return s;
+    }
+#endif
+    return name;
+}
+
+#if defined(SMARTPTRS_DIAGNOSTICS_BACKTRACE)
+// "binary(mangled+0x1f) [addr]" -> demangled name, or the line as given
+inline std::string frameName(const char* line) {
+    const std::string s(line);
+    const std::size_t open = s.find('('), plus = s.find('+', open);
+    if (open == std::string::npos || plus == std::string::npos || plus == open + 1) return s;
+    return demangle(s.substr(open + 1, plus - open - 1).c_str());
+}
+#endif
+
+template<typename T>
+void diagEdgesOf(const diag_record& r, diag_edge_sink& sink) {
+    // r is the first (only) member of the standard-layout tracked<T>
+    const auto& base = *reinterpret_cast<const tracked<T>*>(&r);
+    static_cast<const T&>(base).diagEdges(sink);
+}
+
+template<typename T>
+constexpr diag_edges_fn diagEdgesFor() noexcept {
+    if constexpr (has_diag_edges<T>::value) return &diagEdgesOf<T>;
+    else return nullptr;
+}
+
+template<typename T>
+std::uint16_t diagTypeId() {
+    static const std::uint16_t id =
+        diag_registry::instance().addType(demangle(typeid(T).name()), diagEdgesFor<T>());
+    return id;
+}
+
+} // namespace detail
+
+// Base for counted types: struct Widget : smartptrs::tracked<Widget>
+template<typename T>
+class tracked {
+public:
+    tracked() noexcept { attach(); }
+    tracked(const tracked&) noexcept { attach(); }
+    tracked& operator=(const tracked&) noexcept { return *this; }
+    ~tracked() { detail::diag_registry::instance().remove(record_); }
+
+private:
+    template<typename U>
+    friend const detail::diag_record& detail::recordOf(const tracked<U>&) noexcept;
+
+    void attach() noexcept {
+        record_.type = detail::diagTypeId<T>();
+        record_.site = detail::currentSite();
+#if defined(SMARTPTRS_DIAGNOSTICS_BACKTRACE) && SMARTPTRS_DIAGNOSTICS_STACK_DEPTH > 0
+        record_.depth = std::uint8_t(::backtrace(record_.stack, SMARTPTRS_DIAGNOSTICS_STACK_DEPTH));
+#endif
+        detail::diag_registry::instance().add(record_);
+    }
+
+    detail::diag_record record_;
+};
+
+template<typename U>
+const detail::diag_record& detail::recordOf(const tracked<U>& object) noexcept {
+    return object.record_;
+}
+
+// Labels tracked objects created on this thread while it is in scope
+class alloc_site {
+public:
+    explicit alloc_site(const char* name) noexcept : previous_(detail::currentSite()) {
+        detail::currentSite() = name;
+    }
+    ~alloc_site() { detail::currentSite() = previous_; }
+    alloc_site(const alloc_site&) = delete;
+    alloc_site& operator=(const alloc_site&) = delete;
+
+private:
+    const char* previous_;
+};
+
+#else // !SMARTPTRS_DIAGNOSTICS
+
+template<typename T>
+class tracked {};
+static_assert(std::is_empty_v<tracked<int>> && std::is_trivially_copyable_v<tracked<int>>);
+
+class alloc_site {
+public:
+    explicit constexpr alloc_site(const char*) noexcept {}
+    alloc_site(const alloc_site&) = delete;
+    alloc_site& operator=(const alloc_site&) = delete;
+};
+
+#endif
+
+class diagnostics {
+public:
+#if defined(SMARTPTRS_DIAGNOSTICS)
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    struct type_stats {
+        std::string type;
+        std::uint64_t created = 0;
+        std::uint64_t destroyed = 0;
+        std::int64_t live = 0;
+        std::int64_t peak = 0;
+    };
+
+    // Objects of T alive now (0 when compiled out)
+    template<typename T>
+    static std::int64_t live() {
+#if defined(SMARTPTRS_DIAGNOSTICS)
+        const auto t = detail::diag_registry::instance().totals(detail::diagTypeId<T>());
+        return std::int64_t(t.created - t.destroyed);
+#else
+        return 0;
+#endif
+    }
+
+    // Counts for every type that has had an object (empty when compiled out)
+    static std::vector<type_stats> snapshot() {
+        std::vector<type_stats> out;
+#if defined(SMARTPTRS_DIAGNOSTICS)
+        detail::diag_registry& reg = detail::diag_registry::instance();
+        for (std::size_t i = 0, n = reg.typeCount(); i < n; ++i) {
+            const auto t = reg.totals(i);
+            out.push_back({reg.typeInfo(i).name, t.created, t.destroyed,
+                           std::int64_t(t.created - t.destroyed), t.peak});
+        }
+#endif
+        return out;
+    }
+
+    // Marks a pooled object idle (true) or handed out again (false); idle
+    // objects stay out of the report's list. No-op unless T derives from
+    // some tracked<U>
+    template<typename T>
+    static void setIdle(const T& object, bool idle) noexcept {
+#if defined(SMARTPTRS_DIAGNOSTICS)
+        if constexpr (decltype(detail::isTracked(&object))::value)
+            detail::recordOf(object).idle.store(idle, std::memory_order_relaxed);
+#else
+        (void)object;
+        (void)idle;
+#endif
+    }
+
+    // Per-type counts, then every live object grouped by type, site and stack
+    static void report(std::ostream& os);
+};
+
+#if defined(SMARTPTRS_DIAGNOSTICS)
+
+inline detail::diag_registry::diag_registry() {
+    std::atexit([] { diagnostics::report(std::cerr); });
+}
+
+inline void diagnostics::report(std::ostream& os) {
+    detail::diag_registry& reg = detail::diag_registry::instance();
+    const std::vector<type_stats> types = snapshot();
+    os << "\n=== smartptrs diagnostics ===\n";
+    for (const type_stats& t : types) {
+        os << "  " << t.type << ": live " << t.live << ", peak " << t.peak
+           << ", created " << t.created << ", destroyed " << t.destroyed << '\n';
+    }
+
+    // Snapshot the survivors and their diagEdges() links
+    // (types registered after snapshot() are looked up by id, not by index)
+    std::vector<detail::diag_registry::TypeInfo> info(detail::diag_registry::kMaxTypes);
+    for (std::size_t i = 0; i < info.size(); ++i) info[i] = reg.typeInfo(i);
+    std::vector<const detail::diag_record*> survivors;
+    std::size_t idle = 0;
+    reg.forEachLive([&](const detail::diag_record& r) {
+        if (r.idle.load(std::memory_order_relaxed)) ++idle;
+        else survivors.push_back(&r);
+    });
+    std::unordered_map<const detail::diag_record*, std::size_t> index;
+    for (std::size_t i = 0; i < survivors.size(); ++i) index.emplace(survivors[i], i);
+    std::vector<std::vector<std::size_t>> out(survivors.size());
+    {
+        std::vector<const detail::diag_record*> children;
+        detail::diag_edge_sink sink{&children};
+        for (std::size_t i = 0; i < survivors.size(); ++i) {
+            const detail::diag_edges_fn edges = info[survivors[i]->type].edges;
+            if (!edges) continue;
+            children.clear();
+            edges(*survivors[i], sink);
+            for (const detail::diag_record* c : children) {
+                const auto it = index.find(c);
+                if (it != index.end()) out[i].push_back(it->second);
+            }
+        }
+    }
+
+    // Strongly connected components (iterative Tarjan): members of a
+    // component with more than one node, or with a self-link, are on a cycle
+    const std::size_t n = survivors.size();
+    const std::size_t unvisited = ~std::size_t(0);
+    std::vector<std::size_t> order(n, unvisited), low(n, 0), component(n, unvisited);
+    std::vector<bool> onStack(n, false), onCycle(n, false);
+    std::vector<std::size_t> visiting;
+    std::vector<std::pair<std::size_t, std::size_t>> calls; // (node, next edge)
+    std::size_t counter = 0, components = 0;
+    for (std::size_t start = 0; start < n; ++start) {
+        if (order[start] != unvisited) continue;
+        calls.push_back({start, 0});
+        while (!calls.empty()) {
+            auto& [v, e] = calls.back();
+            if (e == 0 && order[v] == unvisited) {
+                order[v] = low[v] = counter++;
+                visiting.push_back(v);
+                onStack[v] = true;
+            }
+            if (e < out[v].size()) {
+                const std::size_t w = out[v][e++];
+                if (order[w] == unvisited) calls.push_back({w, 0});
+                else if (onStack[w]) low[v] = std::min(low[v], order[w]);
+                continue;
+            }
+            if (low[v] == order[v]) {
+                std::vector<std::size_t> members;
+                std::size_t w;
+                do {
+                    w = visiting.back();
+                    visiting.pop_back();
+                    onStack[w] = false;
+                    component[w] = components;
+                    members.push_back(w);
+                } while (w != v);
+                const bool cyclic = members.size() > 1 ||
+                    std::find(out[v].begin(), out[v].end(), v) != out[v].end();
+                for (std::size_t m : members) onCycle[m] = cyclic;
+                ++components;
+            }
+            const std::size_t done = v;
+            calls.pop_back();
+            if (!calls.empty()) low[calls.back().first] = std::min(low[calls.back().first], low[done]);
+        }
+    }
+
+    // Objects reachable from a cycle are held by it
+    std::vector<bool> heldByCycle(n, false);
+    std::vector<std::size_t> work;
+    for (std::size_t i = 0; i < n; ++i) if (onCycle[i]) work.push_back(i);
+    while (!work.empty()) {
+        const std::size_t v = work.back();
+        work.pop_back();
+        for (std::size_t w : out[v]) {
+            if (!onCycle[w] && !heldByCycle[w]) {
+                heldByCycle[w] = true;
+                work.push_back(w);
+            }
+        }
+    }
+
+    // Group by (type, site, stack, role)
+    using Key = std::tuple<std::uint16_t, std::string, std::vector<void*>, int>;
+    std::map<Key, std::size_t> groups;
+    std::size_t cyclic = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const detail::diag_record& r = *survivors[i];
+        const int role = onCycle[i] ? 1 : heldByCycle[i] ? 2 : 0;
+        cyclic += role != 0;
+        groups[Key{r.type, r.site ? r.site : "(no alloc_site)",
+                   std::vector<void*>(r.stack, r.stack + r.depth), role}]++;
+    }
+    os << "  " << n << " live object" << (n == 1 ? "" : "s");
+    if (n) os << " (" << cyclic << " on or held by a reference cycle)";
+    if (idle) os << ", plus " << idle << " idle in object pools";
+    os << '\n';
+    static const char* const roles[] = {"", " [on a cycle]", " [held by a cycle]"};
+    for (const auto& [key, count] : groups) {
+        const auto& [type, site, stack, role] = key;
+        os << "  " << count << " x " << info[type].name << " from " << site << roles[role] << '\n';
+#if defined(SMARTPTRS_DIAGNOSTICS_BACKTRACE)
+        if (stack.empty()) continue;
+        char** names = ::backtrace_symbols(stack.data(), int(stack.size()));
+        // Frame 0 is tracked<T>::attach itself
+        for (std::size_t f = 1; f < stack.size(); ++f) {
+            os << "      #" << f << ' ' << (names ? detail::frameName(names[f]) : "?") << '\n';
+        }
+        std::free(names);
+#endif
+    }
+    os.flush();
+}
+
+#else
+
+inline void diagnostics::report(std::ostream&) {}
+
+#endif
+
+} // namespace smartptrs
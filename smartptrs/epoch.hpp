@@ -0,0 +1,230 @@
+/*******************************************************************************
+ * epoch.hpp
+ * Epoch-based reclamation for read-mostly shared structures
+ *
+ * Readers of a copy-on-write structure need the snapshot they are reading
+ * to stay alive, but taking a shared_ptr copy per read bounces the control
+ * block's cache line between cores. With epochs, a reader only announces
+ * "I'm reading" in a slot owned by its own thread:
+ *
+ *   {
+ *       smartptrs::epoch_reclaimer::guard pin;      // thread-local store + fence
+ *       Snapshot* s = current.load(std::memory_order_acquire);
+ *       ... read *s ...
+ *   }
+ *
+ * Work handed to other threads (a thread pool) holds a ticket instead: the
+ * same pin, taken on one thread and released on whichever finishes last.
+ *
+ * A writer that unlinks an object hands it to retire(ptr, deleter) instead
+ * of deleting it. The object is destroyed once every thread that could
+ * still be reading it has left its guard (two epoch advances later).
+ *
+ * RULES:
+ *   - Anything reachable under a guard must be retired, never deleted.
+ *   - Guards nest and are cheap, but a long-lived guard holds back all
+ *     reclamation - don't block or wait inside one.
+ *   - Deleters run on whichever thread calls collect() (retire() collects
+ *     every kCollectEvery calls), never under an internal lock, so a
+ *     deleter may itself retire.
+ ******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "retired.hpp"
+
+namespace smartptrs {
+
+class epoch_reclaimer {
+    // One per thread; reused after the thread exits. `local` is 0 when the
+    // thread is outside any guard, otherwise the epoch it observed.
+    struct alignas(64) Record {
+        std::atomic<std::uint64_t> local{0};
+        std::atomic<bool> inUse{true};
+        Record* next = nullptr;
+        unsigned nesting = 0; // owner thread only
+    };
+
+    using Retired = detail::retired_node;
+
+public:
+    static constexpr std::size_t kCollectEvery = 64;
+
+    // Pins the calling thread to the current epoch for its lifetime
+    class guard {
+    public:
+        guard() : record_(threadRecord()) {
+            if (record_.nesting++ == 0) {
+                record_.local.store(state().epoch.load(std::memory_order_relaxed),
+                                    std::memory_order_relaxed);
+                // Orders the announcement before every load made under the guard
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+        ~guard() {
+            if (--record_.nesting == 0) record_.local.store(0, std::memory_order_release);
+        }
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+
+    private:
+        Record& record_;
+    };
+
+    // A pin that isn't tied to a thread: taken where work is handed off and
+    // released (from any thread) when the last piece of it finishes
+    class ticket {
+    public:
+        ticket() : record_(acquireRecord()) {
+            record_->local.store(state().epoch.load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        ticket(ticket&& other) noexcept : record_(std::exchange(other.record_, nullptr)) {}
+        ticket(const ticket&) = delete;
+        ticket& operator=(const ticket&) = delete;
+        ~ticket() { release(); }
+
+        void release() noexcept {
+            if (!record_) return;
+            record_->local.store(0, std::memory_order_release);
+            record_->inUse.store(false, std::memory_order_release);
+            record_ = nullptr;
+        }
+
+    private:
+        Record* record_;
+    };
+
+    // Destroys p with deleter once no guard can still observe it. Call only
+    // after p has been unlinked from every shared location.
+    template<typename T, typename Deleter = std::default_delete<T>>
+    static void retire(T* p, Deleter deleter = Deleter()) {
+        if (!p) return;
+        auto* node = new detail::retired_object<T, Deleter>(p, std::move(deleter));
+        State& s = state();
+        bool collectNow;
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            // Orders the caller's unlink before reading the epoch it retires in
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            node->epoch = s.epoch.load(std::memory_order_seq_cst);
+            node->next = s.limbo;
+            s.limbo = node;
+            ++s.pending;
+            collectNow = ++s.retires % kCollectEvery == 0;
+        }
+        if (collectNow) collect();
+    }
+
+    // Advances the epoch if every pinned thread has caught up, then destroys
+    // whatever became unreachable. Returns the number of objects destroyed.
+    static std::size_t collect() {
+        State& s = state();
+        Retired* ready = nullptr;
+        std::size_t freed = 0;
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            tryAdvance(s);
+            const std::uint64_t now = s.epoch.load(std::memory_order_relaxed);
+            for (Retired** link = &s.limbo; *link;) {
+                Retired* r = *link;
+                if (r->epoch + 2 <= now) {
+                    *link = r->next;
+                    r->next = ready;
+                    ready = r;
+                    ++freed;
+                } else {
+                    link = &r->next;
+                }
+            }
+            s.pending -= freed;
+        }
+        while (ready) delete std::exchange(ready, ready->next);
+        return freed;
+    }
+
+    // Destroys everything retired before the call, waiting for readers that
+    // are still pinned. The caller must not hold a guard or ticket.
+    static void synchronize() {
+        const std::uint64_t target = state().epoch.load(std::memory_order_seq_cst) + 2;
+        collect();
+        while (state().epoch.load(std::memory_order_seq_cst) < target) {
+            std::this_thread::yield();
+            collect();
+        }
+    }
+
+    // Retired objects not yet destroyed
+    static std::size_t pending() {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.pending;
+    }
+
+private:
+    struct State {
+        std::atomic<std::uint64_t> epoch{1}; // 0 means "not pinned"
+        std::atomic<Record*> records{nullptr};
+        std::mutex mutex;                    // guards the fields below
+        Retired* limbo = nullptr;
+        std::size_t pending = 0;
+        std::uint64_t retires = 0;
+    };
+
+    static State& state() {
+        // Never destroyed: guards and retires may run during static destruction
+        static State* s = new State;
+        return *s;
+    }
+
+    // Epoch E may become E+1 only when every pinned thread has seen E
+    static void tryAdvance(State& s) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::uint64_t now = s.epoch.load(std::memory_order_relaxed);
+        for (Record* r = s.records.load(std::memory_order_acquire); r; r = r->next) {
+            const std::uint64_t seen = r->local.load(std::memory_order_seq_cst);
+            if (seen != 0 && seen != now) return;
+        }
+        s.epoch.store(now + 1, std::memory_order_seq_cst);
+    }
+
+    struct ThreadHandle {
+        Record* record;
+        ThreadHandle() : record(acquireRecord()) {}
+        ~ThreadHandle() { record->inUse.store(false, std::memory_order_release); }
+    };
+
+    static Record& threadRecord() {
+        static thread_local ThreadHandle handle;
+        return *handle.record;
+    }
+
+    // Reuses a record left by an exited thread, or links a new one
+    static Record* acquireRecord() {
+        State& s = state();
+        for (Record* r = s.records.load(std::memory_order_acquire); r; r = r->next) {
+            bool idle = false;
+            if (!r->inUse.load(std::memory_order_relaxed) &&
+                r->inUse.compare_exchange_strong(idle, true, std::memory_order_acquire)) {
+                return r;
+            }
+        }
+        auto* fresh = new Record;
+        Record* head = s.records.load(std::memory_order_relaxed);
+        do {
+            fresh->next = head;
+        } while (!s.records.compare_exchange_weak(head, fresh, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+        return fresh;
+    }
+};
+
+} // namespace smartptrs
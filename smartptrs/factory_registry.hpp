@@ -0,0 +1,233 @@
+/*******************************************************************************
+ * factory_registry.hpp
+ * Name -> polymorphic object factory with a compile-time perfect hash
+ *
+ * createShape(type) used to compare the name against every type in turn and
+ * then call new. factory_registry<Base, Types...> is registered at compile
+ * time from a type list; each type names itself:
+ *
+ *   struct Circle : Shape { static constexpr std::string_view kFactoryName = "circle"; ... };
+ *   using ShapeRegistry = smartptrs::factory_registry<Shape, Circle, Square>;
+ *
+ *   std::unique_ptr<Shape> a = ShapeRegistry::create("circle");        // new
+ *   ShapeRegistry::pooled_ptr b = ShapeRegistry::createPooled("square"); // pool block
+ *   smartptrs::arena_ptr<Shape> c = ShapeRegistry::createIn(arena, "circle");
+ *   ShapeRegistry::index("circle");   // 0, in Types... order (npos if unknown)
+ *
+ * Unknown names give nullptr. Arguments after the name are forwarded to the
+ * constructor, so every type must accept them.
+ *
+ * HOW IT WORKS:
+ *   - the perfect hash is built by a constexpr function (hash and
+ *     displace): names are hashed once, split into buckets, and each bucket
+ *     gets a displacement that puts all its names in empty slots. A lookup
+ *     is one hashing pass over the name, a mix, two table reads and one
+ *     string compare, whatever the number of types. Duplicate names fail
+ *     to compile.
+ *   - createPooled() constructs in a block of fixed_block_pool sized for the
+ *     largest type (pointer-sized handle, stateless deleter): after the
+ *     thread's free list is warm it does no heap allocation
+ *   - createIn() uses monotonic_arena::make (see arena.hpp)
+ *
+ * RULES:
+ *   - Base needs a virtual destructor; pooled_ptr frees the block through
+ *     dynamic_cast<void*>, so the handle may hold any base of the object
+ ******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "arena.hpp"
+#include "pool_allocator.hpp"
+
+namespace smartptrs {
+
+namespace detail {
+
+// 64-bit FNV-1a, finished with a multiply-xorshift so low bits mix well
+constexpr std::uint64_t factoryHash(std::string_view s) noexcept {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    h ^= h >> 32;
+    h *= 0xd6e8feb86659fd93ull;
+    return h ^ (h >> 32);
+}
+
+constexpr std::uint64_t factoryMix(std::uint64_t h, std::uint64_t seed) noexcept {
+    h ^= seed * 0x9e3779b97f4a7c15ull;
+    h *= 0xbf58476d1ce4e5b9ull;
+    return h ^ (h >> 31);
+}
+
+constexpr std::size_t factoryPow2(std::size_t n) noexcept {
+    std::size_t p = 1;
+    while (p < n) p *= 2;
+    return p;
+}
+
+template<std::size_t N>
+struct perfect_hash {
+    static constexpr std::size_t kSlots = factoryPow2(2 * N);
+    static constexpr std::size_t kBuckets = factoryPow2(N / 2 + 1);
+
+    std::array<std::uint32_t, kBuckets> displacement{};
+    std::array<std::uint32_t, kSlots> slotIndex{}; // N = empty
+
+    constexpr std::size_t slotOf(std::uint64_t h) const noexcept {
+        return std::size_t(factoryMix(h, displacement[h & (kBuckets - 1)]) >> 32) & (kSlots - 1);
+    }
+};
+
+template<std::size_t N>
+constexpr perfect_hash<N> buildPerfectHash(const std::array<std::string_view, N>& names) {
+    using table = perfect_hash<N>;
+    perfect_hash<N> ph;
+    std::array<std::uint64_t, N> hashes{};
+    for (std::size_t i = 0; i < N; ++i) {
+        hashes[i] = factoryHash(names[i]);
+        for (std::size_t j = 0; j < i; ++j) {
+            if (names[j] == names[i]) throw std::logic_error("factory_registry: duplicate name");
+            if (hashes[j] == hashes[i]) throw std::logic_error("factory_registry: hash collision");
+        }
+    }
+    for (auto& s : ph.slotIndex) s = std::uint32_t(N);
+
+    // Buckets by size, largest first: they are the hardest to place
+    std::array<std::size_t, table::kBuckets> size{}, order{};
+    for (std::size_t i = 0; i < N; ++i) ++size[hashes[i] & (table::kBuckets - 1)];
+    for (std::size_t b = 0; b < table::kBuckets; ++b) order[b] = b;
+    for (std::size_t i = 0; i < table::kBuckets; ++i) {
+        for (std::size_t j = i + 1; j < table::kBuckets; ++j) {
+            if (size[order[j]] > size[order[i]]) {
+                const std::size_t t = order[i];
+                order[i] = order[j];
+                order[j] = t;
+            }
+        }
+    }
+
+    for (std::size_t k = 0; k < table::kBuckets && size[order[k]] > 0; ++k) {
+        const std::size_t b = order[k];
+        std::array<std::size_t, N> members{};
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < N; ++i) {
+            if ((hashes[i] & (table::kBuckets - 1)) == b) members[count++] = i;
+        }
+        for (std::uint32_t d = 0;; ++d) {
+            if (d == (1u << 20)) throw std::logic_error("factory_registry: no displacement found");
+            ph.displacement[b] = d;
+            std::array<std::size_t, N> slots{};
+            bool fits = true;
+            for (std::size_t m = 0; m < count && fits; ++m) {
+                slots[m] = ph.slotOf(hashes[members[m]]);
+                fits = ph.slotIndex[slots[m]] == N;
+                for (std::size_t p = 0; p < m && fits; ++p) fits = slots[p] != slots[m];
+            }
+            if (!fits) continue;
+            for (std::size_t m = 0; m < count; ++m) ph.slotIndex[slots[m]] = std::uint32_t(members[m]);
+            break;
+        }
+    }
+    return ph;
+}
+
+// Destroys the object and returns its block to Pool
+template<typename Pool>
+struct factory_pool_deleter {
+    template<typename T>
+    void operator()(T* p) const noexcept {
+        void* block = dynamic_cast<void*>(p); // most-derived object's address
+        p->~T();
+        Pool::deallocate(block);
+    }
+};
+
+} // namespace detail
+
+template<typename Base, typename... Types>
+class factory_registry {
+    static_assert(sizeof...(Types) > 0, "factory_registry needs at least one type");
+    static_assert(std::has_virtual_destructor_v<Base>, "Base needs a virtual destructor");
+    static_assert((std::is_base_of_v<Base, Types> && ...), "every type must derive from Base");
+
+    static constexpr std::size_t kMaxSize = std::max({sizeof(Types)...});
+    static constexpr std::size_t kMaxAlign = std::max({alignof(Types)...});
+
+public:
+    static constexpr std::size_t npos = ~std::size_t(0);
+    static constexpr std::size_t kCount = sizeof...(Types);
+    static constexpr std::array<std::string_view, kCount> kNames = {Types::kFactoryName...};
+
+    using pool = fixed_block_pool<kMaxSize, kMaxAlign>;
+    using pooled_ptr = std::unique_ptr<Base, detail::factory_pool_deleter<pool>>;
+
+    // Position of name in Types..., or npos
+    static constexpr std::size_t index(std::string_view name) noexcept {
+        const std::uint64_t h = detail::factoryHash(name);
+        const std::size_t i = kHash.slotIndex[kHash.slotOf(h)];
+        return i < kCount && kNames[i] == name ? i : npos;
+    }
+
+    template<typename... Args>
+    static std::unique_ptr<Base> create(std::string_view name, Args&&... args) {
+        const std::size_t i = index(name);
+        if (i == npos) return nullptr;
+        return kHeap<Args&&...>[i](std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    static pooled_ptr createPooled(std::string_view name, Args&&... args) {
+        const std::size_t i = index(name);
+        if (i == npos) return nullptr;
+        void* block = pool::allocate();
+        try {
+            return pooled_ptr(kPlace<Args&&...>[i](block, std::forward<Args>(args)...));
+        } catch (...) {
+            pool::deallocate(block);
+            throw;
+        }
+    }
+
+    template<typename... Args>
+    static arena_ptr<Base> createIn(monotonic_arena& arena, std::string_view name, Args&&... args) {
+        const std::size_t i = index(name);
+        if (i == npos) return nullptr;
+        return kArena<Args&&...>[i](arena, std::forward<Args>(args)...);
+    }
+
+private:
+    static constexpr detail::perfect_hash<kCount> kHash = detail::buildPerfectHash(kNames);
+
+    // One constructor thunk per type, per argument list
+    template<typename... Args>
+    static constexpr std::array<std::unique_ptr<Base> (*)(Args...), kCount> kHeap = {
+        [](Args... args) -> std::unique_ptr<Base> {
+            return std::make_unique<Types>(std::forward<Args>(args)...);
+        }...};
+
+    template<typename... Args>
+    static constexpr std::array<Base* (*)(void*, Args...), kCount> kPlace = {
+        [](void* block, Args... args) -> Base* {
+            return ::new (block) Types(std::forward<Args>(args)...);
+        }...};
+
+    template<typename... Args>
+    static constexpr std::array<arena_ptr<Base> (*)(monotonic_arena&, Args...), kCount> kArena = {
+        [](monotonic_arena& arena, Args... args) -> arena_ptr<Base> {
+            return arena.make<Types>(std::forward<Args>(args)...);
+        }...};
+};
+
+} // namespace smartptrs
@@ -0,0 +1,262 @@
+/*******************************************************************************
+ * file_writer.hpp
+ * Buffered and mmap-backed file writers for high-volume logs (POSIX)
+ *
+ * fprintf per event parses a format string and takes the FILE lock on every
+ * call. These writers own their file (unique_fd, closed on destruction like
+ * unique_ptr<FILE, FileCloser>) and format straight into memory they own:
+ *
+ *   smartptrs::buffered_writer log("events.log", smartptrs::open_mode::append);
+ *   log.print("event ", id, ": ", name, '\n');  // no syscall, no lock
+ *
+ * WRITERS:
+ *   - buffered_writer     fills an owned buffer (default 64 KiB) and writes
+ *                         it with one write() when full. A chunk too big for
+ *                         the space left goes out with the buffer in one
+ *                         writev(), without being copied first.
+ *   - mmap_writer         maps the file and copies into the mapping; grows
+ *                         the file and mapping by a fixed step (default
+ *                         1 MiB) and trims the unused tail on close. Data is
+ *                         in the page cache as soon as it is copied.
+ *
+ * print() accepts characters, integers, bools (as true/false) and anything
+ * convertible to std::string_view, like the trace policies. I/O errors throw
+ * std::system_error, except from destructors, which flush/close and ignore
+ * errors - call close() to see them. Neither writer is thread-safe; give
+ * each thread its own.
+ ******************************************************************************/
+#pragma once
+
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "unique_resource.hpp"
+
+namespace smartptrs {
+
+enum class open_mode { truncate, append };
+
+namespace detail {
+
+[[noreturn]] inline void throwErrno(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+inline unique_fd openForWrite(const char* path, open_mode mode, int extraFlags) {
+    const int flags = O_CREAT | O_CLOEXEC | extraFlags | (mode == open_mode::truncate ? O_TRUNC : 0);
+    unique_fd fd(::open(path, flags, 0644));
+    if (!fd) throwErrno("open");
+    return fd;
+}
+
+// print(): formats each argument with Derived::write(string_view)
+template<typename Derived>
+class writer_format {
+public:
+    template<typename... Args>
+    void print(const Args&... args) {
+        (put(args), ...);
+    }
+
+private:
+    template<typename T>
+    void put(const T& value) {
+        Derived& self = static_cast<Derived&>(*this);
+        if constexpr (std::is_same_v<T, char>) {
+            self.write(std::string_view(&value, 1));
+        } else if constexpr (std::is_same_v<T, bool>) {
+            self.write(value ? std::string_view("true") : std::string_view("false"));
+        } else if constexpr (std::is_integral_v<T>) {
+            char digits[24];
+            const auto result = std::to_chars(digits, digits + sizeof digits, value);
+            self.write(std::string_view(digits, std::size_t(result.ptr - digits)));
+        } else {
+            self.write(std::string_view(value));
+        }
+    }
+};
+
+} // namespace detail
+
+class buffered_writer : public detail::writer_format<buffered_writer> {
+public:
+    static constexpr std::size_t kDefaultBuffer = 64 * 1024;
+
+    buffered_writer(const char* path, open_mode mode = open_mode::truncate,
+                    std::size_t bufferSize = kDefaultBuffer)
+        : buffered_writer(detail::openForWrite(path, mode, O_WRONLY | (mode == open_mode::append ? O_APPEND : 0)),
+                          bufferSize) {}
+
+    explicit buffered_writer(unique_fd fd, std::size_t bufferSize = kDefaultBuffer)
+        : fd_(std::move(fd)), buffer_(new char[bufferSize]), capacity_(bufferSize) {}
+
+    buffered_writer(buffered_writer&& other) noexcept
+        : fd_(std::move(other.fd_)), buffer_(std::move(other.buffer_)),
+          capacity_(std::exchange(other.capacity_, 0)), used_(std::exchange(other.used_, 0)) {}
+    buffered_writer& operator=(buffered_writer&&) = delete;
+    buffered_writer(const buffered_writer&) = delete;
+    buffered_writer& operator=(const buffered_writer&) = delete;
+
+    ~buffered_writer() {
+        try {
+            flush();
+        } catch (const std::system_error&) {
+        }
+    }
+
+    void write(std::string_view data) {
+        if (data.size() <= capacity_ - used_) {
+            std::memcpy(buffer_.get() + used_, data.data(), data.size());
+            used_ += data.size();
+            return;
+        }
+        if (data.size() < capacity_) {
+            flush();
+            std::memcpy(buffer_.get(), data.data(), data.size());
+            used_ = data.size();
+            return;
+        }
+        // Bigger than the whole buffer: send buffer + data in one writev
+        iovec parts[2] = {{buffer_.get(), used_}, {const_cast<char*>(data.data()), data.size()}};
+        writeAll(parts, 2);
+        used_ = 0;
+    }
+
+    void flush() {
+        if (used_ == 0) return;
+        iovec part{buffer_.get(), used_};
+        writeAll(&part, 1);
+        used_ = 0;
+    }
+
+    // Flushes and closes now, reporting errors
+    void close() {
+        flush();
+        if (fd_ && ::close(fd_.release()) != 0) detail::throwErrno("close");
+    }
+
+    std::size_t buffered() const noexcept { return used_; }
+    int fd() const noexcept { return fd_.get(); }
+
+private:
+    void writeAll(iovec* parts, int count) {
+        while (count > 0) {
+            const ssize_t n = ::writev(fd_.get(), parts, count);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                detail::throwErrno("writev");
+            }
+            auto left = std::size_t(n);
+            while (count > 0 && left >= parts->iov_len) {
+                left -= parts->iov_len;
+                ++parts;
+                --count;
+            }
+            if (count > 0) {
+                parts->iov_base = static_cast<char*>(parts->iov_base) + left;
+                parts->iov_len -= left;
+            }
+        }
+    }
+
+    unique_fd fd_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t capacity_;
+    std::size_t used_ = 0;
+};
+
+class mmap_writer : public detail::writer_format<mmap_writer> {
+public:
+    static constexpr std::size_t kDefaultGrowStep = 1024 * 1024;
+
+    // step is rounded up to whole pages
+    mmap_writer(const char* path, open_mode mode = open_mode::truncate,
+                std::size_t growStep = kDefaultGrowStep)
+        : fd_(detail::openForWrite(path, mode, O_RDWR)), step_(pageRound(growStep ? growStep : 1)) {
+        if (mode == open_mode::append) {
+            struct stat st;
+            if (::fstat(fd_.get(), &st) != 0) detail::throwErrno("fstat");
+            size_ = std::size_t(st.st_size);
+        }
+    }
+
+    mmap_writer(mmap_writer&& other) noexcept
+        : fd_(std::move(other.fd_)), map_(std::exchange(other.map_, nullptr)),
+          mapped_(std::exchange(other.mapped_, 0)), size_(std::exchange(other.size_, 0)),
+          step_(other.step_) {}
+    mmap_writer& operator=(mmap_writer&&) = delete;
+    mmap_writer(const mmap_writer&) = delete;
+    mmap_writer& operator=(const mmap_writer&) = delete;
+
+    ~mmap_writer() {
+        try {
+            close();
+        } catch (const std::system_error&) {
+        }
+    }
+
+    void write(std::string_view data) {
+        if (size_ + data.size() > mapped_) grow(size_ + data.size());
+        std::memcpy(map_ + size_, data.data(), data.size());
+        size_ += data.size();
+    }
+
+    // Asks the kernel to start writing dirty pages back (doesn't wait)
+    void flush() {
+        if (map_ && ::msync(map_, mapped_, MS_ASYNC) != 0) detail::throwErrno("msync");
+    }
+
+    // Unmaps, trims the file to the bytes written and closes it
+    void close() {
+        if (!fd_) return;
+        unmap();
+        if (::ftruncate(fd_.get(), off_t(size_)) != 0) detail::throwErrno("ftruncate");
+        if (::close(fd_.release()) != 0) detail::throwErrno("close");
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    std::size_t mappedSize() const noexcept { return mapped_; }
+
+private:
+    static std::size_t pageRound(std::size_t n) {
+        const auto page = std::size_t(::sysconf(_SC_PAGESIZE));
+        return (n + page - 1) / page * page;
+    }
+
+    void grow(std::size_t needed) {
+        const std::size_t target = (needed + step_ - 1) / step_ * step_;
+        unmap();
+        if (::ftruncate(fd_.get(), off_t(target)) != 0) detail::throwErrno("ftruncate");
+        void* p = ::mmap(nullptr, target, PROT_READ | PROT_WRITE, MAP_SHARED, fd_.get(), 0);
+        if (p == MAP_FAILED) detail::throwErrno("mmap");
+        map_ = static_cast<char*>(p);
+        mapped_ = target;
+    }
+
+    void unmap() noexcept {
+        if (map_) ::munmap(map_, mapped_);
+        map_ = nullptr;
+        mapped_ = 0;
+    }
+
+    unique_fd fd_;
+    char* map_ = nullptr;
+    std::size_t mapped_ = 0; // file length while mapped
+    std::size_t size_ = 0;   // bytes written
+    std::size_t step_;
+};
+
+} // namespace smartptrs
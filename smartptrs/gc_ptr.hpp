@@ -0,0 +1,536 @@
+/*******************************************************************************
+ * gc_ptr.hpp
+ * Reference counting with a cycle collector, for graphs whose cycles aren't
+ * known in advance
+ *
+ * cycleDemo() fixes its leak by turning one edge into a weak_ptr, which
+ * needs knowing where the cycles are and costs a lock() per traversal.
+ * gc_ptr<T> counts references like shared_ptr (freeing acyclic garbage
+ * immediately) and finds unreachable cycles by trial deletion (Bacon &
+ * Rajan's synchronous cycle collector):
+ *
+ *   struct Node : smartptrs::gc_object {
+ *       smartptrs::gc_ptr<Node> next;
+ *       void trace(smartptrs::gc_tracer& t) override { t(next); }
+ *   };
+ *   auto a = smartptrs::make_gc<Node>();
+ *   a->next = a;                           // cycle
+ *   a.reset();                             // count 1: a candidate root
+ *   smartptrs::gc_heap::collect();         // finds and frees it
+ *
+ * HOW IT WORKS:
+ *   - a decrement that leaves a count above zero records the object as a
+ *     possible cycle root
+ *   - a cycle takes the pending roots, copies the counts of everything
+ *     reachable from them into trial counts, subtracts the edges inside
+ *     that subgraph, and frees what no outside reference keeps alive.
+ *     Real counts are only changed when garbage is freed: nothing to restore
+ *   - collect(budget) returns after about `budget` object visits. Every
+ *     phase (mark, scan, collect, unlink, free) keeps its work stack and
+ *     cursor in the heap and resumes on the next call, so a pause is
+ *     bounded by the budget even for one 10^6-node cycle or a root inside
+ *     a large live structure; a program can collect a slice per frame/tick.
+ *     Roots arriving while a cycle is unfinished wait for the next cycle
+ *   - between slices the program keeps running. A count change on an
+ *     object the unfinished cycle is still judging (gray or white) makes
+ *     the next slice restart the cycle (gc_stats::restarts); objects of
+ *     the cycle whose count drops to zero are emptied but freed when the
+ *     cycle ends. A graph that changes under every slice may never finish
+ *     a budgeted cycle: collect() without a budget always does
+ *   - an object whose count reaches zero while it is a candidate root is
+ *     emptied at once but its memory waits for collect(); call it regularly
+ *     even in mostly acyclic code
+ *   - all traversals use explicit work lists, so deep graphs don't recurse
+ *   - gc_ptr is one pointer: operator-> is a plain load, no lock()
+ *
+ * RULES:
+ *   - T derives from gc_object and its trace() passes every gc_ptr member
+ *     to the tracer. A missed edge makes the collector free live objects.
+ *   - The collector never runs implicitly; call collect().
+ *   - Counts are not atomic: a graph and every gc_ptr into it must stay on
+ *     one thread, and each thread collects its own roots.
+ *   - gc_ptr members are already null when a collected object's destructor
+ *     runs.
+ ******************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace smartptrs {
+
+class gc_object;
+class gc_heap;
+template<typename T> class gc_ptr;
+
+// Passed to gc_object::trace(); collects (and in some phases unlinks) edges
+class gc_tracer {
+public:
+    template<typename T>
+    void operator()(gc_ptr<T>& edge) noexcept {
+        if (!edge.ptr_) return;
+        edges_.push_back(edge.ptr_);
+        if (unlink_) edge.ptr_ = nullptr;
+    }
+
+private:
+    friend class gc_heap;
+    std::vector<gc_object*> edges_;
+    bool unlink_ = false;
+};
+
+class gc_object {
+public:
+    virtual ~gc_object() = default;
+    // Pass every gc_ptr member to t
+    virtual void trace(gc_tracer& t) = 0;
+
+protected:
+    gc_object() = default;
+    gc_object(const gc_object&) noexcept {}
+    gc_object& operator=(const gc_object&) noexcept { return *this; }
+
+private:
+    friend class gc_heap;
+    template<typename T> friend class gc_ptr;
+    // red: garbage found by the cycle, waiting to be unlinked and freed
+    enum class color : std::uint8_t { black, gray, white, purple, red };
+
+    std::uint32_t refs_ = 0;
+    std::uint32_t trial_ = 0; // refs_ minus edges inside the cycle's subgraph
+    color color_ = color::black;
+    bool buffered_ = false; // in the candidate-root list
+    bool traced_ = false;   // part of the unfinished cycle's subgraph
+};
+
+struct gc_stats {
+    std::uint64_t collections = 0;
+    std::uint64_t visited = 0;    // objects traversed by the collector
+    std::uint64_t freed = 0;      // objects freed by collect()
+    std::uint64_t lastPauseNs = 0;
+    std::uint64_t maxPauseNs = 0;
+    std::uint64_t restarts = 0;   // cycles restarted after the graph changed under them
+    std::size_t pendingRoots = 0;
+    bool collecting = false;      // a cycle is unfinished: collect() has work
+};
+
+class gc_heap {
+public:
+    static constexpr std::size_t kUnlimited = ~std::size_t(0);
+
+    // Runs (or resumes) trial deletion from pending roots until ~budget
+    // objects have been visited; returns the number of objects freed
+    static std::size_t collect(std::size_t budget = kUnlimited) {
+        if (retired()) return 0;
+        return local().run(budget);
+    }
+
+    static gc_stats stats() {
+        if (retired()) return {};
+        Heap& h = local();
+        gc_stats s = h.stats;
+        s.pendingRoots = h.roots.size();
+        s.collecting = h.at != phase::idle;
+        return s;
+    }
+
+private:
+    template<typename T> friend class gc_ptr;
+    using color = gc_object::color;
+
+    enum class phase : std::uint8_t { idle, mark, scan, collect, unlink, reset, free };
+
+    // One cycle's state, kept between collect() calls. Every pointer in it
+    // is to a traced_ object (freed only by the cycle) or to garbage
+    struct Heap {
+        std::vector<gc_object*> roots;
+        std::vector<gc_object*> releasing;
+        std::vector<gc_object*> work;     // mark / scanBlack / collect stack
+        std::vector<gc_object*> pending;  // scan stack
+        std::vector<gc_object*> batch;    // roots the cycle took
+        std::vector<gc_object*> traced;   // everything it grayed
+        std::vector<gc_object*> garbage;  // red
+        std::vector<gc_object*> outside;  // non-garbage targets of garbage edges
+        std::vector<gc_object*> deferred; // traced objects that reached count zero
+        std::size_t cursor = 0;
+        phase at = phase::idle;
+        bool taking = false;   // the cycle may still take roots
+        bool dirty = false;    // gray or white count changed since the last slice
+        bool aborting = false; // reset phase undoes the cycle instead of finishing it
+        gc_tracer tracer;
+        bool draining = false;
+        gc_stats stats;
+
+        ~Heap() {
+            run(kUnlimited);
+            retired() = true;
+        }
+
+        std::size_t run(std::size_t budget);
+        bool step(std::size_t budget, std::size_t& visited, std::size_t& freed);
+        void gray(gc_object* o);
+        void abort();
+
+        // A traced object's count changed outside the collector
+        void touched(const gc_object* o) noexcept {
+            if (o->color_ == color::gray || o->color_ == color::white) dirty = true;
+        }
+
+        // Edges of o, left in tracer.edges_
+        std::vector<gc_object*>& edges(gc_object* o, bool unlink) {
+            tracer.edges_.clear();
+            tracer.unlink_ = unlink;
+            o->trace(tracer);
+            return tracer.edges_;
+        }
+    };
+
+    static Heap& local() {
+        static thread_local Heap heap;
+        return heap;
+    }
+
+    static bool& retired() noexcept {
+        static thread_local bool flag = false; // trivially destructible
+        return flag;
+    }
+
+    static void increment(gc_object* o) noexcept {
+        if (o->traced_) local().touched(o);
+        ++o->refs_;
+        o->color_ = color::black;
+    }
+
+    static void decrement(gc_object* o) {
+        if (o->traced_) local().touched(o);
+        if (--o->refs_ == 0) {
+            release(o);
+        } else if (o->color_ != color::purple && !retired()) {
+            o->color_ = color::purple; // possible root of a garbage cycle
+            if (!o->buffered_) {
+                o->buffered_ = true;
+                local().roots.push_back(o);
+            }
+        }
+    }
+
+    // o's count reached zero: unlink its edges, decrement the targets and
+    // free it, iteratively so long chains don't recurse through destructors
+    static void release(gc_object* o) {
+        if (retired()) {
+            gc_tracer t;
+            t.unlink_ = true;
+            o->trace(t);
+            delete o;
+            for (gc_object* e : t.edges_) decrement(e);
+            return;
+        }
+        Heap& h = local();
+        h.releasing.push_back(o);
+        if (h.draining) return;
+        h.draining = true;
+        while (!h.releasing.empty()) {
+            gc_object* dead = h.releasing.back();
+            h.releasing.pop_back();
+            dead->color_ = color::black;
+            for (gc_object* t : h.edges(dead, true)) {
+                if (t->traced_) h.touched(t);
+                if (--t->refs_ == 0) {
+                    h.releasing.push_back(t);
+                } else if (t->color_ != color::purple) {
+                    t->color_ = color::purple;
+                    if (!t->buffered_) {
+                        t->buffered_ = true;
+                        h.roots.push_back(t);
+                    }
+                }
+            }
+            // Still in the root list: collect() frees it when it gets there.
+            // Part of an unfinished cycle: freed when the cycle ends
+            if (dead->traced_) h.deferred.push_back(dead);
+            else if (!dead->buffered_) delete dead;
+        }
+        h.draining = false;
+    }
+};
+
+template<typename T>
+class gc_ptr {
+public:
+    gc_ptr() noexcept = default;
+    gc_ptr(std::nullptr_t) noexcept {}
+
+    gc_ptr(const gc_ptr& other) noexcept : ptr_(other.ptr_) { addRef(); }
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    gc_ptr(const gc_ptr<U>& other) noexcept : ptr_(other.ptr_) { addRef(); }
+    gc_ptr(gc_ptr&& other) noexcept : ptr_(std::exchange(other.ptr_, nullptr)) {}
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    gc_ptr(gc_ptr<U>&& other) noexcept : ptr_(std::exchange(other.ptr_, nullptr)) {}
+
+    ~gc_ptr() { reset(); }
+
+    gc_ptr& operator=(gc_ptr other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    // Drops the reference (the object is only freed if this was the last)
+    void reset() {
+        if (T* p = std::exchange(ptr_, nullptr)) gc_heap::decrement(p);
+    }
+
+    void swap(gc_ptr& other) noexcept { std::swap(ptr_, other.ptr_); }
+
+    T* get() const noexcept { return ptr_; }
+    T& operator*() const noexcept { return *ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    std::uint32_t use_count() const noexcept { return ptr_ ? ptr_->refs_ : 0; }
+
+    friend bool operator==(const gc_ptr& a, const gc_ptr& b) noexcept { return a.ptr_ == b.ptr_; }
+    friend bool operator!=(const gc_ptr& a, const gc_ptr& b) noexcept { return a.ptr_ != b.ptr_; }
+
+private:
+    template<typename U> friend class gc_ptr;
+    friend class gc_tracer;
+    template<typename U, typename... Args> friend gc_ptr<U> make_gc(Args&&... args);
+
+    struct adopt {};
+    gc_ptr(T* p, adopt) noexcept : ptr_(p) { addRef(); }
+
+    void addRef() noexcept {
+        if (ptr_) gc_heap::increment(ptr_);
+    }
+
+    T* ptr_ = nullptr;
+};
+
+template<typename T, typename... Args>
+gc_ptr<T> make_gc(Args&&... args) {
+    static_assert(std::is_base_of_v<gc_object, T>, "make_gc<T>: T must derive from gc_object");
+    return gc_ptr<T>(new T(std::forward<Args>(args)...), typename gc_ptr<T>::adopt{});
+}
+
+inline std::size_t gc_heap::Heap::run(std::size_t budget) {
+    if (at == phase::idle && roots.empty()) return 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    if (dirty && (at == phase::mark || at == phase::scan || at == phase::collect)) abort();
+    std::size_t visited = 0, freed = 0;
+    while (visited < budget && step(budget, visited, freed)) {}
+
+    const auto pause = std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    ++stats.collections;
+    stats.visited += visited;
+    stats.freed += freed;
+    stats.lastPauseNs = pause;
+    if (pause > stats.maxPauseNs) stats.maxPauseNs = pause;
+    return freed;
+}
+
+// Runs the current phase until it ends (true: go on with the next one) or
+// the budget is spent (false: resume here on the next call)
+inline bool gc_heap::Heap::step(std::size_t budget, std::size_t& visited, std::size_t& freed) {
+    switch (at) {
+    case phase::idle:
+        if (roots.empty()) return false;
+        at = phase::mark;
+        taking = true;
+        dirty = false;
+        return true;
+
+    case phase::mark: // gray everything reachable from the roots, subtracting internal edges
+        while (visited < budget) {
+            if (work.empty()) {
+                if (!taking || roots.empty()) {
+                    at = phase::scan;
+                    cursor = 0;
+                    return true;
+                }
+                gc_object* r = roots.back(); // newest first
+                roots.pop_back();
+                r->buffered_ = false;
+                if (r->color_ == color::purple && r->refs_ > 0 && !r->traced_) {
+                    gray(r);
+                    batch.push_back(r);
+                } else if (r->color_ == color::black && r->refs_ == 0) { // released while buffered
+                    delete r;
+                    ++freed;
+                    ++visited;
+                }
+                continue;
+            }
+            gc_object* o = work.back();
+            work.pop_back();
+            ++visited;
+            for (gc_object* t : edges(o, false)) {
+                if (!t->traced_) gray(t);
+                --t->trial_;
+            }
+        }
+        taking = false; // later slices finish this batch before taking more
+        return false;
+
+    case phase::scan: // gray with a positive trial count: live, and so is all it reaches
+        while (visited < budget) {
+            if (!work.empty()) { // blacken below a live object
+                gc_object* o = work.back();
+                work.pop_back();
+                ++visited;
+                for (gc_object* t : edges(o, false)) {
+                    if (t->traced_ && (t->color_ == color::gray || t->color_ == color::white)) {
+                        t->color_ = color::black;
+                        work.push_back(t);
+                    }
+                }
+            } else if (!pending.empty()) {
+                gc_object* o = pending.back();
+                pending.pop_back();
+                if (o->color_ != color::gray) continue;
+                ++visited;
+                if (o->trial_ > 0) {
+                    o->color_ = color::black;
+                    work.push_back(o);
+                } else {
+                    o->color_ = color::white;
+                    for (gc_object* t : edges(o, false)) pending.push_back(t);
+                }
+            } else if (cursor < batch.size()) {
+                pending.push_back(batch[cursor++]);
+            } else {
+                at = phase::collect;
+                cursor = 0;
+                return true;
+            }
+        }
+        return false;
+
+    case phase::collect: // what stayed white is garbage
+        while (visited < budget) {
+            if (work.empty()) {
+                if (cursor == batch.size()) {
+                    batch.clear();
+                    at = phase::unlink;
+                    cursor = 0;
+                    return true;
+                }
+                work.push_back(batch[cursor++]);
+                continue;
+            }
+            gc_object* o = work.back();
+            work.pop_back();
+            if (o->color_ != color::white) continue;
+            ++visited;
+            o->color_ = color::red;
+            for (gc_object* t : edges(o, false)) {
+                if (t->color_ == color::white) work.push_back(t);
+            }
+            garbage.push_back(o);
+        }
+        return false;
+
+    case phase::unlink: // all garbage first, so no destructor touches a freed peer
+        while (visited < budget) {
+            if (cursor == garbage.size()) {
+                at = phase::reset;
+                cursor = 0;
+                return true;
+            }
+            gc_object* g = garbage[cursor++];
+            ++visited;
+            for (gc_object* t : edges(g, true)) {
+                if (t->color_ != color::red) outside.push_back(t); // still counts g's edge
+            }
+        }
+        return false;
+
+    case phase::reset: // the cycle is over: clear traced_, free what died meanwhile
+        while (visited < budget) {
+            if (cursor == traced.size()) {
+                for (gc_object* z : deferred) {
+                    if (!z->buffered_) {
+                        delete z;
+                        ++freed;
+                    }
+                }
+                deferred.clear();
+                traced.clear();
+                at = aborting ? phase::idle : phase::free;
+                aborting = false;
+                cursor = 0;
+                return true;
+            }
+            gc_object* o = traced[cursor++];
+            ++visited;
+            o->traced_ = false;
+            if (o->color_ != color::purple && (aborting || o->color_ != color::red)) o->color_ = color::black;
+        }
+        return false;
+
+    case phase::free: // garbage, then the counts its edges held on live objects
+        while (visited < budget) {
+            if (cursor < garbage.size()) {
+                gc_object* g = garbage[cursor++];
+                ++visited;
+                if (g->buffered_) {
+                    // Also a root not yet taken: left emptied with count
+                    // zero for that root's turn, which frees it
+                    g->refs_ = 0;
+                    g->color_ = color::black;
+                } else {
+                    delete g;
+                    ++freed;
+                }
+            } else if (cursor < garbage.size() + outside.size()) {
+                gc_object* t = outside[cursor++ - garbage.size()];
+                ++visited;
+                decrement(t);
+            } else {
+                garbage.clear();
+                outside.clear();
+                at = phase::idle;
+                cursor = 0;
+                return true;
+            }
+        }
+        return false;
+    }
+    return false;
+}
+
+inline void gc_heap::Heap::gray(gc_object* o) {
+    o->color_ = color::gray;
+    o->traced_ = true;
+    o->trial_ = o->refs_;
+    traced.push_back(o);
+    work.push_back(o);
+}
+
+// The graph changed under the cycle: give its roots back, then undo the
+// colors in the reset phase
+inline void gc_heap::Heap::abort() {
+    for (gc_object* r : batch) {
+        if (r->refs_ > 0 && !r->buffered_) {
+            r->color_ = color::purple;
+            r->buffered_ = true;
+            roots.push_back(r);
+        }
+    }
+    batch.clear();
+    work.clear();
+    pending.clear();
+    garbage.clear();
+    ++stats.restarts;
+    dirty = false;
+    aborting = true;
+    at = phase::reset;
+    cursor = 0;
+}
+
+} // namespace smartptrs
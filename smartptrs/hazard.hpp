@@ -0,0 +1,230 @@
+/*******************************************************************************
+ * hazard.hpp
+ * Hazard pointers: per-pointer protection for readers of shared objects
+ *
+ * weak_ptr::lock() and shared_ptr copies write the control block, so many
+ * readers of one object fight over its cache line. A hazard pointer reader
+ * instead publishes "I'm using p" in a slot owned by its own thread:
+ *
+ *   std::atomic<Widget*> current;
+ *   {
+ *       smartptrs::hazard_reclaimer::guard hp;
+ *       Widget* w = hp.protect(current);  // store + fence + re-check
+ *       if (w) w->greet();
+ *   }
+ *
+ * A writer that swaps `current` retires the old object with any deleter:
+ *
+ *   smartptrs::hazard_reclaimer::retire(old);                // delete
+ *   smartptrs::hazard_reclaimer::retire(fp, FileCloser());   // custom
+ *
+ * Retired objects wait in a list owned by the retiring thread. Every
+ * kScanThreshold retires the thread scans all hazard slots and destroys
+ * whatever no slot names. Lists left by exited threads are adopted by the
+ * next scan.
+ *
+ * HAZARD POINTERS vs EPOCHS (epoch.hpp):
+ *   - a hazard guard protects one pointer; an epoch guard protects
+ *     everything reachable while pinned (whole snapshots, linked nodes)
+ *   - a stalled hazard reader holds back only the object it protects; a
+ *     stalled epoch reader holds back all reclamation
+ *   - protect() re-reads the source after the fence, so it costs a little
+ *     more per pointer than an epoch pin per section
+ *
+ * Each thread has kSlotsPerThread slots; nesting more guards than that
+ * throws std::length_error.
+ ******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "retired.hpp"
+
+namespace smartptrs {
+
+class hazard_reclaimer {
+public:
+    static constexpr std::size_t kSlotsPerThread = 4;
+    static constexpr std::size_t kScanThreshold = 64;
+
+private:
+    struct alignas(64) Record {
+        std::atomic<const void*> slots[kSlotsPerThread] = {};
+        std::atomic<bool> inUse{true};
+        Record* next = nullptr;
+        unsigned used = 0; // bitmask of taken slots, owner thread only
+    };
+
+public:
+    // Owns one hazard slot of the calling thread
+    class guard {
+    public:
+        guard() : record_(threadState().record), index_(takeSlot(*record_)) {}
+        ~guard() {
+            record_->slots[index_].store(nullptr, std::memory_order_release);
+            record_->used &= ~(1u << index_);
+        }
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+
+        // Loads src and keeps the result alive until reset() or ~guard()
+        template<typename T>
+        T* protect(const std::atomic<T*>& src) noexcept {
+            T* p = src.load(std::memory_order_relaxed);
+            for (;;) {
+                record_->slots[index_].store(p, std::memory_order_relaxed);
+                // Orders the announcement before the re-check (pairs with scan)
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                T* again = src.load(std::memory_order_acquire);
+                if (again == p) return p;
+                p = again;
+            }
+        }
+
+        void reset() noexcept { record_->slots[index_].store(nullptr, std::memory_order_release); }
+
+    private:
+        Record* record_;
+        unsigned index_;
+    };
+
+    // Destroys p with deleter once no hazard slot holds it. Call only after
+    // p has been unlinked from every shared location.
+    template<typename T, typename Deleter = std::default_delete<T>>
+    static void retire(T* p, Deleter deleter = Deleter()) {
+        if (!p) return;
+        auto* node = new detail::retired_object<T, Deleter>(p, std::move(deleter));
+        ThreadState& ts = threadState();
+        node->next = ts.retired;
+        ts.retired = node;
+        global().pending.fetch_add(1, std::memory_order_relaxed);
+        if (++ts.count >= kScanThreshold) scan(ts);
+    }
+
+    // Scans the calling thread's list (and orphans) now; returns the number
+    // of objects destroyed
+    static std::size_t collect() { return scan(threadState()); }
+
+    // Retired objects not yet destroyed (all threads)
+    static std::size_t pending() noexcept { return global().pending.load(std::memory_order_relaxed); }
+
+private:
+    using Retired = detail::retired_node;
+
+    struct Global {
+        std::atomic<Record*> records{nullptr};
+        std::atomic<std::size_t> pending{0};
+        std::mutex orphanMutex;
+        Retired* orphans = nullptr; // left behind by exited threads
+    };
+
+    struct ThreadState {
+        Record* record = acquireRecord();
+        Retired* retired = nullptr;
+        std::size_t count = 0;
+
+        ~ThreadState() {
+            scan(*this);
+            if (retired) {
+                Retired* last = retired;
+                while (last->next) last = last->next;
+                Global& g = global();
+                std::lock_guard<std::mutex> lock(g.orphanMutex);
+                last->next = g.orphans;
+                g.orphans = retired;
+            }
+            record->inUse.store(false, std::memory_order_release);
+        }
+    };
+
+    static Global& global() {
+        // Never destroyed: threads may exit during static destruction
+        static Global* g = new Global;
+        return *g;
+    }
+
+    static ThreadState& threadState() {
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    static unsigned takeSlot(Record& r) {
+        for (unsigned i = 0; i < kSlotsPerThread; ++i) {
+            if (!(r.used & (1u << i))) {
+                r.used |= 1u << i;
+                return i;
+            }
+        }
+        throw std::length_error("hazard_reclaimer: more than kSlotsPerThread nested guards");
+    }
+
+    static Record* acquireRecord() {
+        Global& g = global();
+        for (Record* r = g.records.load(std::memory_order_acquire); r; r = r->next) {
+            bool idle = false;
+            if (!r->inUse.load(std::memory_order_relaxed) &&
+                r->inUse.compare_exchange_strong(idle, true, std::memory_order_acquire)) {
+                return r;
+            }
+        }
+        auto* fresh = new Record;
+        Record* head = g.records.load(std::memory_order_relaxed);
+        do {
+            fresh->next = head;
+        } while (!g.records.compare_exchange_weak(head, fresh, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+        return fresh;
+    }
+
+    // Destroys this thread's (and any orphaned) retired objects that no
+    // hazard slot names; deleters run with no lock held
+    static std::size_t scan(ThreadState& ts) {
+        Global& g = global();
+        Retired* list = std::exchange(ts.retired, nullptr);
+        ts.count = 0;
+        {
+            std::unique_lock<std::mutex> lock(g.orphanMutex, std::try_to_lock);
+            if (lock && g.orphans) {
+                Retired* last = std::exchange(g.orphans, nullptr);
+                Retired* first = last;
+                while (last->next) last = last->next;
+                last->next = list;
+                list = first;
+            }
+        }
+        if (!list) return 0;
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<const void*> hazards;
+        for (Record* r = g.records.load(std::memory_order_acquire); r; r = r->next) {
+            for (const auto& slot : r->slots) {
+                if (const void* p = slot.load(std::memory_order_seq_cst)) hazards.push_back(p);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        std::size_t freed = 0;
+        while (list) {
+            Retired* r = std::exchange(list, list->next);
+            if (std::binary_search(hazards.begin(), hazards.end(), r->address)) {
+                r->next = ts.retired; // still protected: keep for the next scan
+                ts.retired = r;
+                ++ts.count;
+            } else {
+                delete r; // may retire more, onto ts.retired
+                ++freed;
+            }
+        }
+        g.pending.fetch_sub(freed, std::memory_order_relaxed);
+        return freed;
+    }
+};
+
+} // namespace smartptrs
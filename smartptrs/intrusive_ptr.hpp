@@ -0,0 +1,289 @@
+/*******************************************************************************
+ * intrusive_ptr.hpp
+ * Intrusive reference counting: the count lives inside the object
+ *
+ * shared_ptr keeps its counts in a separate control block and is two words
+ * wide. intrusive_ptr<T> is one word, and copying it touches only the
+ * object's own header - usually the same cache line as the data you're
+ * about to use.
+ *
+ * USAGE:
+ *   struct Texture : smartptrs::ref_counted<Texture> { ... };
+ *   auto t = smartptrs::make_intrusive<Texture>(args...);
+ *
+ * COUNTER POLICIES (compile time):
+ *   - thread_safe_count   atomic increments, safe to share across threads
+ *   - single_thread_count plain increments, for objects that never leave
+ *                         their thread
+ *
+ * WEAK REFERENCES (optional, third template argument = true):
+ *   The first weak_intrusive_ptr allocates a small side table holding the
+ *   weak count and a back pointer. Objects that are never observed weakly
+ *   pay one pointer of storage and never allocate the table.
+ *
+ * Any type can be used with intrusive_ptr by providing ADL-visible
+ * intrusive_ptr_add_ref(const T*) and intrusive_ptr_release(const T*).
+ * ref_counted deletes through Derived*, so a hierarchy rooted at Derived
+ * needs a virtual destructor in Derived.
+ ******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "sync.hpp"
+
+namespace smartptrs {
+
+struct thread_safe_count {
+    using counter = std::atomic<long>;
+    using mutex_type = spin_lock;
+
+    static void increment(counter& c) noexcept { c.fetch_add(1, std::memory_order_relaxed); }
+    // True when the count dropped to zero
+    static bool decrement(counter& c) noexcept {
+        // acq_rel: the last owner must see every other owner's writes
+        return c.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+    static bool incrementIfNonZero(counter& c) noexcept {
+        long n = c.load(std::memory_order_relaxed);
+        while (n != 0) {
+            if (c.compare_exchange_weak(n, n + 1, std::memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+    static long load(const counter& c) noexcept { return c.load(std::memory_order_relaxed); }
+};
+
+struct single_thread_count {
+    using counter = long;
+    using mutex_type = null_mutex;
+
+    static void increment(counter& c) noexcept { ++c; }
+    static bool decrement(counter& c) noexcept { return --c == 0; }
+    static bool incrementIfNonZero(counter& c) noexcept { return c != 0 && ++c; }
+    static long load(const counter& c) noexcept { return c; }
+};
+
+struct adopt_ref_t { explicit adopt_ref_t() = default; };
+inline constexpr adopt_ref_t adopt_ref{};
+
+template<typename T> class intrusive_ptr;
+template<typename T> class weak_intrusive_ptr;
+
+namespace detail {
+
+// Allocated on first weak_intrusive_ptr. The live object owns one weak
+// reference; the mutex orders lock() against the last strong release.
+template<typename Derived, typename Policy>
+struct weak_side_table {
+    typename Policy::mutex_type mutex;
+    typename Policy::counter weakRefs{1};
+    Derived* object;
+
+    explicit weak_side_table(Derived* obj) : object(obj) {}
+    void addWeak() noexcept { Policy::increment(weakRefs); }
+    void releaseWeak() noexcept {
+        if (Policy::decrement(weakRefs)) delete this;
+    }
+};
+
+// Storage for the side table pointer; empty when weak refs are disabled
+// (used as a base so the empty case takes no space)
+template<typename Table, typename Policy, bool Weak>
+struct weak_slot {};
+
+template<typename Table>
+struct weak_slot<Table, thread_safe_count, true> {
+    mutable std::atomic<Table*> side_{nullptr};
+    Table* loadSide() const noexcept { return side_.load(std::memory_order_acquire); }
+    bool installSide(Table*& expected, Table* table) const noexcept {
+        return side_.compare_exchange_strong(expected, table, std::memory_order_acq_rel);
+    }
+};
+
+template<typename Table>
+struct weak_slot<Table, single_thread_count, true> {
+    mutable Table* side_ = nullptr;
+    Table* loadSide() const noexcept { return side_; }
+    bool installSide(Table*& expected, Table* table) const noexcept {
+        if (side_ != expected) { expected = side_; return false; }
+        side_ = table;
+        return true;
+    }
+};
+
+} // namespace detail
+
+// CRTP base holding the reference count (and optionally the weak side
+// table pointer). Copying a ref_counted object does not copy its count.
+template<typename Derived, typename Policy = thread_safe_count, bool Weak = false>
+class ref_counted
+    : private detail::weak_slot<detail::weak_side_table<Derived, Policy>, Policy, Weak> {
+public:
+    using count_policy = Policy;
+    static constexpr bool supports_weak = Weak;
+
+    long use_count() const noexcept { return Policy::load(refs_); }
+
+protected:
+    ref_counted() noexcept = default;
+    ref_counted(const ref_counted&) noexcept {}
+    ref_counted& operator=(const ref_counted&) noexcept { return *this; }
+    ~ref_counted() = default;
+
+private:
+    using side_table = detail::weak_side_table<Derived, Policy>;
+
+    friend void intrusive_ptr_add_ref(const ref_counted* p) noexcept {
+        Policy::increment(p->refs_);
+    }
+
+    friend void intrusive_ptr_release(const ref_counted* p) noexcept {
+        if (!Policy::decrement(p->refs_)) return;
+        if constexpr (Weak) {
+            if (side_table* side = p->loadSide()) {
+                {
+                    std::lock_guard<typename Policy::mutex_type> lock(side->mutex);
+                    side->object = nullptr;
+                }
+                side->releaseWeak();
+            }
+        }
+        delete static_cast<const Derived*>(p);
+    }
+
+    // Side table for weak_intrusive_ptr, created on first use. Caller holds
+    // a strong reference, so the object can't die concurrently.
+    side_table* weakTable() const {
+        side_table* side = this->loadSide();
+        if (side) return side;
+        auto* fresh = new side_table(const_cast<Derived*>(static_cast<const Derived*>(this)));
+        if (this->installSide(side, fresh)) return fresh;
+        delete fresh; // another thread won the race
+        return side;
+    }
+
+    friend class weak_intrusive_ptr<Derived>;
+
+    mutable typename Policy::counter refs_{0};
+};
+
+template<typename T>
+class intrusive_ptr {
+public:
+    using element_type = T;
+
+    constexpr intrusive_ptr() noexcept = default;
+    constexpr intrusive_ptr(std::nullptr_t) noexcept {}
+    explicit intrusive_ptr(T* p) noexcept : ptr_(p) { if (ptr_) intrusive_ptr_add_ref(ptr_); }
+    intrusive_ptr(T* p, adopt_ref_t) noexcept : ptr_(p) {}
+
+    intrusive_ptr(const intrusive_ptr& other) noexcept : intrusive_ptr(other.ptr_) {}
+    intrusive_ptr(intrusive_ptr&& other) noexcept : ptr_(std::exchange(other.ptr_, nullptr)) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    intrusive_ptr(const intrusive_ptr<U>& other) noexcept : intrusive_ptr(other.get()) {}
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    intrusive_ptr(intrusive_ptr<U>&& other) noexcept : ptr_(other.detach()) {}
+
+    ~intrusive_ptr() { if (ptr_) intrusive_ptr_release(ptr_); }
+
+    intrusive_ptr& operator=(const intrusive_ptr& other) noexcept {
+        intrusive_ptr(other).swap(*this);
+        return *this;
+    }
+    intrusive_ptr& operator=(intrusive_ptr&& other) noexcept {
+        intrusive_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept { intrusive_ptr().swap(*this); }
+    void reset(T* p) noexcept { intrusive_ptr(p).swap(*this); }
+    void swap(intrusive_ptr& other) noexcept { std::swap(ptr_, other.ptr_); }
+
+    // Gives up ownership without decrementing; pair with adopt_ref
+    T* detach() noexcept { return std::exchange(ptr_, nullptr); }
+
+    T* get() const noexcept { return ptr_; }
+    T& operator*() const noexcept { return *ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+    long use_count() const noexcept { return ptr_ ? ptr_->use_count() : 0; }
+
+private:
+    T* ptr_ = nullptr;
+};
+
+template<typename T, typename U>
+bool operator==(const intrusive_ptr<T>& a, const intrusive_ptr<U>& b) noexcept { return a.get() == b.get(); }
+template<typename T, typename U>
+bool operator!=(const intrusive_ptr<T>& a, const intrusive_ptr<U>& b) noexcept { return a.get() != b.get(); }
+template<typename T>
+bool operator==(const intrusive_ptr<T>& a, std::nullptr_t) noexcept { return !a; }
+template<typename T>
+bool operator!=(const intrusive_ptr<T>& a, std::nullptr_t) noexcept { return static_cast<bool>(a); }
+
+template<typename T, typename... Args>
+intrusive_ptr<T> make_intrusive(Args&&... args) {
+    return intrusive_ptr<T>(new T(std::forward<Args>(args)...));
+}
+
+// Non-owning observer of a ref_counted<T, Policy, true> object. Points at
+// the side table, never at the object, so it stays valid after T dies.
+template<typename T>
+class weak_intrusive_ptr {
+    using policy = typename T::count_policy;
+    using side_table = detail::weak_side_table<T, policy>;
+    static_assert(T::supports_weak, "enable weak support: ref_counted<T, Policy, true>");
+
+public:
+    constexpr weak_intrusive_ptr() noexcept = default;
+    weak_intrusive_ptr(const intrusive_ptr<T>& strong) {
+        if (strong) {
+            side_ = strong->weakTable();
+            side_->addWeak();
+        }
+    }
+    weak_intrusive_ptr(const weak_intrusive_ptr& other) noexcept : side_(other.side_) {
+        if (side_) side_->addWeak();
+    }
+    weak_intrusive_ptr(weak_intrusive_ptr&& other) noexcept
+        : side_(std::exchange(other.side_, nullptr)) {}
+    ~weak_intrusive_ptr() { if (side_) side_->releaseWeak(); }
+
+    weak_intrusive_ptr& operator=(weak_intrusive_ptr other) noexcept {
+        std::swap(side_, other.side_);
+        return *this;
+    }
+
+    intrusive_ptr<T> lock() const noexcept {
+        if (!side_) return {};
+        std::lock_guard<typename policy::mutex_type> guard(side_->mutex);
+        T* obj = side_->object;
+        if (obj && policy::incrementIfNonZero(obj->refs_)) return intrusive_ptr<T>(obj, adopt_ref);
+        return {};
+    }
+
+    bool expired() const noexcept { return !lock(); }
+    void reset() noexcept { weak_intrusive_ptr().swap(*this); }
+    void swap(weak_intrusive_ptr& other) noexcept { std::swap(side_, other.side_); }
+
+private:
+    side_table* side_ = nullptr;
+};
+
+} // namespace smartptrs
+
+namespace std {
+template<typename T>
+struct hash<smartptrs::intrusive_ptr<T>> {
+    size_t operator()(const smartptrs::intrusive_ptr<T>& p) const noexcept {
+        return hash<T*>{}(p.get());
+    }
+};
+} // namespace std
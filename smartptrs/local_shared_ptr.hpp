@@ -0,0 +1,207 @@
+/*******************************************************************************
+ * local_shared_ptr.hpp
+ * Shared ownership with a non-atomic reference count
+ *
+ * std::shared_ptr pays a locked read-modify-write on every copy and
+ * destruction, even when the object never leaves its thread (per-connection
+ * event loops, single-threaded pipelines). local_shared_ptr<T> has the same
+ * shape - two words, control block, make_local_shared for a single
+ * allocation - but counts with plain increments.
+ *
+ * RULES:
+ *   - Every copy, destruction and dereference must happen on the thread
+ *     that created the object. Debug builds (no NDEBUG) assert this.
+ *   - There is no weak_ptr counterpart; use std::shared_ptr when objects
+ *     need to be observed or shared across threads.
+ ******************************************************************************/
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace smartptrs {
+
+namespace detail {
+
+class local_control_block {
+public:
+    void addRef() noexcept {
+        checkOwner();
+        ++refs_;
+    }
+    void release() noexcept {
+        checkOwner();
+        if (--refs_ == 0) destroy();
+    }
+    long useCount() const noexcept { return refs_; }
+
+    void checkOwner() const noexcept {
+#ifndef NDEBUG
+        assert(owner_ == std::this_thread::get_id() &&
+               "local_shared_ptr used outside its owning thread");
+#endif
+    }
+
+protected:
+    local_control_block() = default;
+    virtual ~local_control_block() = default;
+    virtual void destroy() noexcept = 0; // destroys the object and the block
+
+private:
+    long refs_ = 1;
+#ifndef NDEBUG
+    std::thread::id owner_ = std::this_thread::get_id();
+#endif
+};
+
+// Object and counts in one allocation (make_local_shared)
+template<typename T>
+class local_inplace_block final : public local_control_block {
+public:
+    template<typename... Args>
+    explicit local_inplace_block(Args&&... args) {
+        ::new (static_cast<void*>(&storage_)) T(std::forward<Args>(args)...);
+    }
+    T* object() noexcept { return std::launder(reinterpret_cast<T*>(&storage_)); }
+
+private:
+    void destroy() noexcept override {
+        object()->~T();
+        delete this;
+    }
+    alignas(T) unsigned char storage_[sizeof(T)];
+};
+
+// Adopts a separately allocated object
+template<typename T, typename Deleter>
+class local_pointer_block final : public local_control_block {
+public:
+    local_pointer_block(T* p, Deleter d) : ptr_(p), deleter_(std::move(d)) {}
+
+private:
+    void destroy() noexcept override {
+        deleter_(ptr_);
+        delete this;
+    }
+    T* ptr_;
+    Deleter deleter_;
+};
+
+} // namespace detail
+
+template<typename T>
+class local_shared_ptr {
+public:
+    using element_type = T;
+
+    constexpr local_shared_ptr() noexcept = default;
+    constexpr local_shared_ptr(std::nullptr_t) noexcept {}
+
+    template<typename U, typename Deleter = std::default_delete<U>,
+             typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    explicit local_shared_ptr(U* p, Deleter d = Deleter()) {
+        // Like shared_ptr: if allocating the block throws, p is deleted
+        std::unique_ptr<U, Deleter> guard(p, d);
+        block_ = new detail::local_pointer_block<U, Deleter>(p, std::move(d));
+        guard.release();
+        ptr_ = p;
+    }
+
+    template<typename U, typename Deleter,
+             typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    local_shared_ptr(std::unique_ptr<U, Deleter>&& owner)
+        : local_shared_ptr(owner.get(), owner.get_deleter()) {
+        owner.release();
+    }
+
+    // Aliasing: shares r's ownership but points at p (e.g. a member)
+    template<typename U>
+    local_shared_ptr(const local_shared_ptr<U>& r, T* p) noexcept : ptr_(p), block_(r.block_) {
+        if (block_) block_->addRef();
+    }
+
+    local_shared_ptr(const local_shared_ptr& other) noexcept
+        : ptr_(other.ptr_), block_(other.block_) {
+        if (block_) block_->addRef();
+    }
+    local_shared_ptr(local_shared_ptr&& other) noexcept
+        : ptr_(std::exchange(other.ptr_, nullptr)), block_(std::exchange(other.block_, nullptr)) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    local_shared_ptr(const local_shared_ptr<U>& other) noexcept
+        : ptr_(other.ptr_), block_(other.block_) {
+        if (block_) block_->addRef();
+    }
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    local_shared_ptr(local_shared_ptr<U>&& other) noexcept
+        : ptr_(std::exchange(other.ptr_, nullptr)), block_(std::exchange(other.block_, nullptr)) {}
+
+    ~local_shared_ptr() { if (block_) block_->release(); }
+
+    local_shared_ptr& operator=(const local_shared_ptr& other) noexcept {
+        local_shared_ptr(other).swap(*this);
+        return *this;
+    }
+    local_shared_ptr& operator=(local_shared_ptr&& other) noexcept {
+        local_shared_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept { local_shared_ptr().swap(*this); }
+    void swap(local_shared_ptr& other) noexcept {
+        std::swap(ptr_, other.ptr_);
+        std::swap(block_, other.block_);
+    }
+
+    T* get() const noexcept {
+        checkOwner();
+        return ptr_;
+    }
+    T& operator*() const noexcept { return *get(); }
+    T* operator->() const noexcept { return get(); }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+    long use_count() const noexcept { return block_ ? block_->useCount() : 0; }
+
+private:
+    template<typename U> friend class local_shared_ptr;
+    template<typename U, typename... Args>
+    friend local_shared_ptr<U> make_local_shared(Args&&... args);
+
+    struct adopt_block_t {};
+    local_shared_ptr(adopt_block_t, T* p, detail::local_control_block* block) noexcept
+        : ptr_(p), block_(block) {}
+
+    void checkOwner() const noexcept {
+        if (block_) block_->checkOwner();
+    }
+
+    T* ptr_ = nullptr;
+    detail::local_control_block* block_ = nullptr;
+};
+
+// Single allocation for object + count, like make_shared
+template<typename T, typename... Args>
+local_shared_ptr<T> make_local_shared(Args&&... args) {
+    auto* block = new detail::local_inplace_block<T>(std::forward<Args>(args)...);
+    return local_shared_ptr<T>(typename local_shared_ptr<T>::adopt_block_t{}, block->object(), block);
+}
+
+template<typename T, typename U>
+bool operator==(const local_shared_ptr<T>& a, const local_shared_ptr<U>& b) noexcept {
+    return a.get() == b.get();
+}
+template<typename T, typename U>
+bool operator!=(const local_shared_ptr<T>& a, const local_shared_ptr<U>& b) noexcept {
+    return !(a == b);
+}
+template<typename T>
+bool operator==(const local_shared_ptr<T>& a, std::nullptr_t) noexcept { return !a; }
+template<typename T>
+bool operator!=(const local_shared_ptr<T>& a, std::nullptr_t) noexcept { return static_cast<bool>(a); }
+
+} // namespace smartptrs
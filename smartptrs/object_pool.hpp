@@ -0,0 +1,300 @@
+/*******************************************************************************
+ * object_pool.hpp
+ * Pool of live objects handed out as unique_ptr with a recycling deleter
+ *
+ * make_unique/unique_ptr destruction pays for construction, destruction and
+ * an allocation every cycle. ObjectPool<T> keeps released objects alive and
+ * hands them out again:
+ *
+ *   using Pool = smartptrs::ObjectPool<Widget>;
+ *   Pool::handle w = Pool::acquire(1, "first");  // miss: new Widget(1, "first")
+ *   w.reset();                                   // back to the pool, not freed
+ *   Pool::handle again = Pool::acquire(2);       // hit: the same Widget, now Widget(2)
+ *
+ * POLICIES:
+ *   - acquire(args...) always yields an object made from args. On a miss
+ *     that is a new T(args...); on a hit the recycled object is
+ *     re-initialized by t.init(args...) when T has one (keeping whatever
+ *     it owns, e.g. buffer capacity), and otherwise destroyed and rebuilt
+ *     from args in the same storage. Only the allocation is saved then;
+ *     give T an init() to save the construction too. If rebuilding throws,
+ *     the storage is freed and the exception propagates
+ *   - acquire() without arguments returns a hit as Reset left it
+ *   - Reset (default pool_reset: calls t.reset() when T has one) runs as the
+ *     handle is destroyed, before the object goes back. If it throws, the
+ *     object is destroyed instead of pooled (the deleter is noexcept)
+ *   - like fixed_block_pool, each thread keeps its own free list and moves
+ *     kBatch objects at a time to and from a shared pool under one lock.
+ *     Objects released on another thread rejoin through that pool. Beyond
+ *     kMaxIdle shared idle objects, spilled batches are deleted.
+ *
+ * Idle objects are marked with diagnostics::setIdle, so a diagnostics
+ * build doesn't list the ones the (never destroyed) pool still holds at
+ * exit as leaks.
+ *
+ * stats() reports hit rate and the peak number of objects alive. Hit/miss
+ * counts are folded in per thread every kBatch acquires, so they can lag by
+ * that much per running thread.
+ ******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "diagnostics.hpp"
+
+namespace smartptrs {
+
+// Default reset policy: t.reset() if T has one, otherwise leave t as is
+struct pool_reset {
+    template<typename T>
+    void operator()(T& t) const {
+        if constexpr (has_reset<T>::value) t.reset();
+    }
+
+private:
+    template<typename T, typename = void>
+    struct has_reset : std::false_type {};
+    template<typename T>
+    struct has_reset<T, std::void_t<decltype(std::declval<T&>().reset())>> : std::true_type {};
+};
+
+struct pool_stats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::size_t size = 0;     // objects alive: in use + idle
+    std::size_t peakSize = 0;
+    std::size_t idle = 0;     // in the shared pool (not counting thread lists)
+
+    double hitRate() const noexcept {
+        return hits + misses ? double(hits) / double(hits + misses) : 0.0;
+    }
+};
+
+template<typename T, typename Reset = pool_reset>
+class ObjectPool {
+public:
+    static constexpr std::size_t kBatch = 64;        // objects moved per shared transfer
+    static constexpr std::size_t kMaxIdle = 64 * kBatch;
+
+    struct PoolReturner {
+        void operator()(T* p) const noexcept { ObjectPool::release(p); }
+    };
+    using handle = std::unique_ptr<T, PoolReturner>;
+
+    template<typename... Args>
+    static handle acquire(Args&&... args) {
+        T* p = takeIdle();
+        if (!p) return handle(create(std::forward<Args>(args)...));
+        diagnostics::setIdle(*p, false);
+        if constexpr (sizeof...(Args) > 0) reinit(p, std::forward<Args>(args)...);
+        return handle(p);
+    }
+
+    // Deletes idle objects in the shared pool down to `keep`
+    static void shrink(std::size_t keep = 0) {
+        std::vector<T*> doomed;
+        {
+            Global& g = global();
+            std::lock_guard<std::mutex> lock(g.mutex);
+            if (g.idle.size() <= keep) return;
+            doomed.assign(g.idle.begin() + std::ptrdiff_t(keep), g.idle.end());
+            g.idle.resize(keep);
+        }
+        destroy(doomed.data(), doomed.size());
+    }
+
+    static pool_stats stats() {
+        if (!retired()) threadCache().fold();
+        Global& g = global();
+        pool_stats s;
+        s.hits = g.hits.load(std::memory_order_relaxed);
+        s.misses = g.misses.load(std::memory_order_relaxed);
+        s.size = g.size.load(std::memory_order_relaxed);
+        s.peakSize = g.peakSize.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(g.mutex);
+        s.idle = g.idle.size();
+        return s;
+    }
+
+private:
+    struct Global {
+        std::mutex mutex;
+        std::vector<T*> idle;
+        std::atomic<std::uint64_t> hits{0};
+        std::atomic<std::uint64_t> misses{0};
+        std::atomic<std::size_t> size{0};
+        std::atomic<std::size_t> peakSize{0};
+
+        // Moves up to kBatch idle objects onto out
+        void take(std::vector<T*>& out) {
+            std::lock_guard<std::mutex> lock(mutex);
+            const std::size_t n = std::min(kBatch, idle.size());
+            out.insert(out.end(), idle.end() - std::ptrdiff_t(n), idle.end());
+            idle.resize(idle.size() - n);
+        }
+
+        // Takes [first, first + n) unless the pool is full; returns false
+        // if the caller should delete them instead
+        bool give(T* const* first, std::size_t n) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (idle.size() + n > kMaxIdle) return false;
+            idle.insert(idle.end(), first, first + n);
+            return true;
+        }
+
+        // Slow path for threads whose cache is already destroyed
+        T* takeOne() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (idle.empty()) return nullptr;
+            T* p = idle.back();
+            idle.pop_back();
+            return p;
+        }
+    };
+
+    struct ThreadCache {
+        std::vector<T*> objects;
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+
+        ThreadCache() { objects.reserve(2 * kBatch); }
+
+        void refill() { global().take(objects); }
+
+        // Hands the oldest kBatch objects to the shared pool
+        void spill() {
+            T* const* first = objects.data();
+            if (!global().give(first, kBatch)) destroy(first, kBatch);
+            objects.erase(objects.begin(), objects.begin() + std::ptrdiff_t(kBatch));
+        }
+
+        void fold() {
+            Global& g = global();
+            g.hits.fetch_add(std::exchange(hits, 0), std::memory_order_relaxed);
+            g.misses.fetch_add(std::exchange(misses, 0), std::memory_order_relaxed);
+        }
+
+        // Thread exit: cached objects go to the shared pool, and later calls
+        // on this thread go straight to it
+        ~ThreadCache() {
+            fold();
+            while (objects.size() >= kBatch) spill();
+            if (!objects.empty() && !global().give(objects.data(), objects.size())) {
+                destroy(objects.data(), objects.size());
+            }
+            retired() = true;
+        }
+    };
+
+    template<typename U, typename = void, typename... Args>
+    struct has_init : std::false_type {};
+    template<typename U, typename... Args>
+    struct has_init<U, std::void_t<decltype(std::declval<U&>().init(std::declval<Args>()...))>, Args...>
+        : std::true_type {};
+
+    // A recycled object off this thread's list (or the shared pool), or null
+    static T* takeIdle() {
+        if (retired()) return global().takeOne();
+        T* p = nullptr;
+        ThreadCache& cache = threadCache();
+        if (cache.objects.empty()) cache.refill();
+        if (!cache.objects.empty()) {
+            p = cache.objects.back();
+            cache.objects.pop_back();
+        }
+        if (p) ++cache.hits;
+        else ++cache.misses;
+        if (cache.hits + cache.misses >= kBatch) cache.fold();
+        return p;
+    }
+
+    // Objects live in storage from std::allocator<T>, so a hit can be
+    // rebuilt in place and its storage freed alone if that throws
+    template<typename... Args>
+    static T* create(Args&&... args) {
+        std::allocator<T> alloc;
+        T* p = alloc.allocate(1);
+        try {
+            alloc_site site("ObjectPool::acquire");
+            ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            alloc.deallocate(p, 1);
+            throw;
+        }
+        Global& g = global();
+        const std::size_t now = g.size.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::size_t peak = g.peakSize.load(std::memory_order_relaxed);
+        while (now > peak && !g.peakSize.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+        return p;
+    }
+
+    template<typename... Args>
+    static void reinit(T* p, Args&&... args) {
+        if constexpr (has_init<T, void, Args&&...>::value) {
+            p->init(std::forward<Args>(args)...);
+        } else {
+            p->~T();
+            try {
+                alloc_site site("ObjectPool::acquire");
+                ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+            } catch (...) {
+                std::allocator<T>().deallocate(p, 1);
+                global().size.fetch_sub(1, std::memory_order_relaxed);
+                throw;
+            }
+        }
+    }
+
+    static void destroy(T* const* objects, std::size_t n) noexcept {
+        std::allocator<T> alloc;
+        for (std::size_t i = 0; i < n; ++i) {
+            objects[i]->~T();
+            alloc.deallocate(objects[i], 1);
+        }
+        global().size.fetch_sub(n, std::memory_order_relaxed);
+    }
+
+    static void release(T* p) noexcept {
+        try {
+            Reset()(*p);
+        } catch (...) {
+            destroy(&p, 1); // state unknown: not fit to hand out again
+            return;
+        }
+        diagnostics::setIdle(*p, true);
+        if (retired()) {
+            if (!global().give(&p, 1)) destroy(&p, 1);
+            return;
+        }
+        ThreadCache& cache = threadCache();
+        cache.objects.push_back(p); // never reallocates: spilled at 2 * kBatch
+        if (cache.objects.size() >= 2 * kBatch) cache.spill();
+    }
+
+    static Global& global() {
+        // Never destroyed: handles may be released during static destruction
+        static Global* g = new Global;
+        return *g;
+    }
+
+    static ThreadCache& threadCache() {
+        static thread_local ThreadCache cache;
+        return cache;
+    }
+
+    static bool& retired() noexcept {
+        static thread_local bool flag = false; // trivially destructible
+        return flag;
+    }
+};
+
+} // namespace smartptrs
@@ -0,0 +1,101 @@
+/*******************************************************************************
+ * padded_shared.hpp
+ * make_shared with the reference counts on their own cache line
+ *
+ * make_shared<Widget> puts the control block (vtable pointer, use and weak
+ * counts: 16 bytes) and the Widget in one allocation, so the counts and
+ * Widget::id usually share a 64-byte line. A thread that writes w->id and
+ * a thread that copies w then invalidate each other's line on every
+ * operation although they never touch the same bytes (false sharing).
+ *
+ *   auto w = smartptrs::make_shared_padded<Widget>(1, "hot");   // shared_ptr<Widget>
+ *   auto p = smartptrs::allocate_shared_padded<Widget>(pool_allocator<Widget>(), 2);
+ *   auto a = smartptrs::make_shared_padded_array<Counter>(threads); // a[i].value
+ *
+ * DETAILS:
+ *   - the object is stored as cache_padded<T>, aligned to and padded to a
+ *     multiple of kCacheLineSize. The fused control block's storage for it
+ *     is therefore aligned too: the counts fill the first line alone and
+ *     the object starts on the next one; the allocation is over-aligned,
+ *     so no neighbouring allocation shares either line
+ *   - the returned shared_ptr<T> is an aliasing pointer into the padded
+ *     value: one allocation, same size and copy cost as make_shared
+ *   - the cost is memory: at least two lines per object (128 bytes for a
+ *     Widget that make_shared fits in 64), so pad only objects that are
+ *     written while other threads copy their pointer
+ *   - make_shared_padded_array<T>(n [, init]) is make_shared_array
+ *     (batch_make.hpp) over cache_padded<T>: the control block and each
+ *     element get lines of their own, so per-thread slots never share one
+ ******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "batch_make.hpp"
+
+namespace smartptrs {
+
+// Destructive interference size of current x86-64 and most ARM cores
+// (std::hardware_destructive_interference_size warns when used in headers)
+inline constexpr std::size_t kCacheLineSize = 64;
+
+template<typename T> struct cache_padded;
+
+namespace detail {
+
+// One argument that is already a cache_padded<T>: copy/move, not T(arg)
+template<typename T, typename... Args>
+struct is_padded_self : std::false_type {};
+template<typename T, typename A>
+struct is_padded_self<T, A> : std::is_same<std::decay_t<A>, cache_padded<T>> {};
+
+} // namespace detail
+
+// T on cache lines of its own
+template<typename T>
+struct alignas(alignof(T) > kCacheLineSize ? alignof(T) : kCacheLineSize) cache_padded {
+    T value;
+
+    template<typename... Args, typename = std::enable_if_t<std::is_constructible_v<T, Args...> &&
+                                                           !detail::is_padded_self<T, Args...>::value>>
+    explicit cache_padded(Args&&... args) : value(std::forward<Args>(args)...) {}
+
+    T& operator*() noexcept { return value; }
+    const T& operator*() const noexcept { return value; }
+    T* operator->() noexcept { return &value; }
+    const T* operator->() const noexcept { return &value; }
+};
+
+static_assert(sizeof(cache_padded<char>) == kCacheLineSize && alignof(cache_padded<char>) == kCacheLineSize);
+
+// allocate_shared, with the counts and the object on separate cache lines.
+// alloc is rebound like any allocate_shared allocator and must honour the
+// cache-line alignment of the block (std::allocator, pool_allocator do)
+template<typename T, typename Alloc, typename... Args>
+std::shared_ptr<T> allocate_shared_padded(const Alloc& alloc, Args&&... args) {
+    auto padded = std::allocate_shared<cache_padded<T>>(alloc, std::forward<Args>(args)...);
+    T* object = &padded->value;
+    return std::shared_ptr<T>(std::move(padded), object);
+}
+
+template<typename T, typename... Args>
+std::shared_ptr<T> make_shared_padded(Args&&... args) {
+    return allocate_shared_padded<T>(std::allocator<cache_padded<T>>(), std::forward<Args>(args)...);
+}
+
+// n value-initialized elements, each on its own cache line(s)
+template<typename T>
+std::shared_ptr<cache_padded<T>[]> make_shared_padded_array(std::size_t n) {
+    return make_shared_array<cache_padded<T>>(n);
+}
+
+// n copies of init, each on its own cache line(s)
+template<typename T>
+std::shared_ptr<cache_padded<T>[]> make_shared_padded_array(std::size_t n, const T& init) {
+    return make_shared_array<cache_padded<T>>(n, cache_padded<T>(init));
+}
+
+} // namespace smartptrs
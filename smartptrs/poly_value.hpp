@@ -0,0 +1,169 @@
+/*******************************************************************************
+ * poly_value.hpp
+ * Polymorphic value with small-buffer storage
+ *
+ * unique_ptr<Shape> costs a heap allocation per object even for empty types
+ * like Circle, and a vector of them is a vector of pointers to scattered
+ * blocks. poly_value<Base, Size> stores any type derived from Base inline
+ * when it fits in Size bytes, and on the heap otherwise:
+ *
+ *   smartptrs::poly_value<Shape> s = Circle{};              // inline
+ *   s.emplace<Polygon>(points);                             // heap if large
+ *   s->draw();                                              // virtual call
+ *   std::vector<smartptrs::poly_value<Shape>> shapes;       // values, not pointers
+ *   auto t = s;                                             // copies the Polygon
+ *
+ * DETAILS:
+ *   - destruction goes through Base's virtual destructor, as with
+ *     unique_ptr<Base> (see polymorphicDeletionExample): ~Derived, then ~Base
+ *   - a type is stored inline if sizeof <= Size, alignof <= Align and its
+ *     move constructor is noexcept (fits_inline<T>), so moving a
+ *     poly_value never throws; heap-stored values move by pointer
+ *   - moved-from and default-constructed values are empty (bool false)
+ *   - copying requires the stored type to be copy constructible; copying a
+ *     poly_value holding one that isn't throws std::logic_error
+ *   - get() is a stored Base*, so access costs the same load as unique_ptr
+ *     and works for bases at a non-zero offset
+ ******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace smartptrs {
+
+template<typename Base, std::size_t Size = 32, std::size_t Align = alignof(std::max_align_t)>
+class poly_value {
+    static_assert(std::has_virtual_destructor_v<Base>, "Base needs a virtual destructor");
+
+public:
+    template<typename T>
+    static constexpr bool fits_inline = sizeof(T) <= Size && alignof(T) <= Align &&
+                                        std::is_nothrow_move_constructible_v<T>;
+
+    poly_value() noexcept = default;
+
+    template<typename T, typename... Args>
+    explicit poly_value(std::in_place_type_t<T>, Args&&... args) {
+        emplace<T>(std::forward<Args>(args)...);
+    }
+
+    // From a derived object: poly_value<Shape> s = Circle{};
+    template<typename T, typename D = std::decay_t<T>,
+             typename = std::enable_if_t<!std::is_same_v<D, poly_value> && std::is_base_of_v<Base, D>>>
+    poly_value(T&& value) {
+        emplace<D>(std::forward<T>(value));
+    }
+
+    poly_value(const poly_value& other) {
+        if (!other.ops_) return;
+        if (!other.ops_->copy) throw std::logic_error("poly_value: stored type is not copyable");
+        ptr_ = other.ops_->copy(other.ptr_, buffer_);
+        ops_ = other.ops_;
+    }
+
+    poly_value(poly_value&& other) noexcept { take(other); }
+
+    poly_value& operator=(const poly_value& other) {
+        if (this != &other) {
+            poly_value copy(other);
+            reset();
+            take(copy);
+        }
+        return *this;
+    }
+
+    poly_value& operator=(poly_value&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~poly_value() { reset(); }
+
+    // Destroys the current value (if any) and constructs a T
+    template<typename T, typename... Args>
+    T& emplace(Args&&... args) {
+        static_assert(std::is_base_of_v<Base, T>, "T must derive from Base");
+        reset();
+        T* p;
+        if constexpr (fits_inline<T>) p = ::new (static_cast<void*>(buffer_)) T(std::forward<Args>(args)...);
+        else p = new T(std::forward<Args>(args)...);
+        ptr_ = p;
+        ops_ = &kOps<T>;
+        return *p;
+    }
+
+    void reset() noexcept {
+        if (!ops_) return;
+        if (ops_->heap) delete ptr_;
+        else ptr_->~Base();
+        ptr_ = nullptr;
+        ops_ = nullptr;
+    }
+
+    Base* get() noexcept { return ptr_; }
+    const Base* get() const noexcept { return ptr_; }
+    Base* operator->() noexcept { return ptr_; }
+    const Base* operator->() const noexcept { return ptr_; }
+    Base& operator*() noexcept { return *ptr_; }
+    const Base& operator*() const noexcept { return *ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    // True if the value lives in the inline buffer
+    bool inlined() const noexcept { return ops_ && !ops_->heap; }
+
+private:
+    struct ops {
+        bool heap;
+        // Moves the inline object at from into buffer to and destroys the source
+        Base* (*move)(Base* from, void* to) noexcept;
+        // Copies into buffer to (inline) or onto the heap; null if not copyable
+        Base* (*copy)(const Base* from, void* to);
+    };
+
+    template<typename T>
+    static Base* moveInline(Base* from, void* to) noexcept {
+        T* src = static_cast<T*>(from);
+        T* dst = ::new (to) T(std::move(*src));
+        src->~T();
+        return dst;
+    }
+
+    template<typename T>
+    static Base* copyValue(const Base* from, void* to) {
+        const T& src = *static_cast<const T*>(from);
+        if constexpr (fits_inline<T>) return ::new (to) T(src);
+        else return new T(src);
+    }
+
+    template<typename T>
+    static constexpr ops makeOps() noexcept {
+        ops o{!fits_inline<T>, nullptr, nullptr};
+        if constexpr (fits_inline<T>) o.move = &moveInline<T>;
+        if constexpr (std::is_copy_constructible_v<T>) o.copy = &copyValue<T>;
+        return o;
+    }
+
+    template<typename T>
+    static constexpr ops kOps = makeOps<T>();
+
+    void take(poly_value& other) noexcept {
+        if (!other.ops_) return;
+        ptr_ = other.ops_->heap ? other.ptr_ : other.ops_->move(other.ptr_, buffer_);
+        ops_ = other.ops_;
+        other.ptr_ = nullptr;
+        other.ops_ = nullptr;
+    }
+
+    Base* ptr_ = nullptr;
+    const ops* ops_ = nullptr;
+    alignas(Align) unsigned char buffer_[Size];
+};
+
+} // namespace smartptrs
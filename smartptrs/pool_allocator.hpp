@@ -0,0 +1,201 @@
+/*******************************************************************************
+ * pool_allocator.hpp
+ * Fixed-size block pool with per-thread free lists, usable as an allocator
+ *
+ * fixed_block_pool<Size, Align> hands out blocks of one size:
+ *   - each thread pops/pushes blocks on its own free list (no locking)
+ *   - lists move to and from a global pool in batches of kBatch blocks
+ *     under a mutex, so the lock is taken once per kBatch operations
+ *   - the global pool carves new blocks from large slabs; slabs are kept
+ *     for the life of the process
+ *
+ * pool_allocator<T> plugs the pool into the allocator-aware std APIs.
+ * Single-object requests go to the pool for sizeof(T); anything else falls
+ * back to operator new. Since allocate_shared rebinds the allocator to its
+ * internal control block type, the pool is sized for the fused
+ * "control block + T" layout automatically:
+ *
+ *   auto w = std::allocate_shared<Widget>(smartptrs::pool_allocator<Widget>(), 1, "pooled");
+ *
+ * Blocks may be freed on any thread; they join that thread's free list.
+ ******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace smartptrs {
+
+template<std::size_t Size, std::size_t Align = alignof(std::max_align_t)>
+class fixed_block_pool {
+    static_assert((Align & (Align - 1)) == 0, "alignment must be a power of two");
+
+    struct FreeBlock { FreeBlock* next; };
+
+public:
+    static constexpr std::size_t kAlign = Align > alignof(FreeBlock) ? Align : alignof(FreeBlock);
+    static constexpr std::size_t kBlockSize =
+        ((Size > sizeof(FreeBlock) ? Size : sizeof(FreeBlock)) + kAlign - 1) / kAlign * kAlign;
+    static constexpr std::size_t kBatch = 64;          // blocks moved per global transfer
+    static constexpr std::size_t kSlabBatches = 16;    // batches carved per slab
+
+    static void* allocate() {
+        if (retired()) return global().takeOne();
+        ThreadCache& cache = threadCache();
+        if (!cache.head) cache.refill();
+        FreeBlock* b = cache.head;
+        cache.head = b->next;
+        --cache.count;
+        return b;
+    }
+
+    static void deallocate(void* p) noexcept {
+        auto* b = static_cast<FreeBlock*>(p);
+        if (retired()) {
+            b->next = nullptr;
+            global().give({b, 1});
+            return;
+        }
+        ThreadCache& cache = threadCache();
+        b->next = cache.head;
+        cache.head = b;
+        if (++cache.count >= 2 * kBatch) cache.spill();
+    }
+
+    // Slabs obtained from operator new so far (all threads)
+    static std::size_t slabCount() {
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mutex);
+        return g.slabs.size();
+    }
+
+private:
+    // A chain of blocks linked through FreeBlock::next (usually kBatch long)
+    struct Batch {
+        FreeBlock* head;
+        std::size_t count;
+    };
+
+    struct Global {
+        std::mutex mutex;
+        std::vector<Batch> batches;
+        std::vector<void*> slabs;
+
+        Batch take() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (batches.empty()) carveSlab();
+            Batch b = batches.back();
+            batches.pop_back();
+            return b;
+        }
+
+        void give(Batch b) {
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back(b);
+        }
+
+        // Slow path for threads whose cache is already destroyed
+        void* takeOne() {
+            Batch b = take();
+            FreeBlock* block = b.head;
+            if (b.count > 1) give({block->next, b.count - 1});
+            return block;
+        }
+
+        void carveSlab() {
+            const std::size_t bytes = kBlockSize * kBatch * kSlabBatches;
+            char* slab = static_cast<char*>(kAlign > __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                ? ::operator new(bytes, std::align_val_t(kAlign))
+                : ::operator new(bytes));
+            slabs.push_back(slab);
+            for (std::size_t b = 0; b < kSlabBatches; ++b) {
+                char* first = slab + b * kBatch * kBlockSize;
+                for (std::size_t i = 0; i < kBatch; ++i) {
+                    auto* block = reinterpret_cast<FreeBlock*>(first + i * kBlockSize);
+                    block->next = i + 1 < kBatch
+                        ? reinterpret_cast<FreeBlock*>(first + (i + 1) * kBlockSize) : nullptr;
+                }
+                batches.push_back({reinterpret_cast<FreeBlock*>(first), kBatch});
+            }
+        }
+    };
+
+    struct ThreadCache {
+        FreeBlock* head = nullptr;
+        std::size_t count = 0;
+
+        void refill() {
+            Batch b = global().take();
+            head = b.head;
+            count = b.count;
+        }
+
+        // Hands kBatch blocks back to the global pool
+        void spill() {
+            FreeBlock* first = head;
+            FreeBlock* last = head;
+            for (std::size_t i = 1; i < kBatch; ++i) last = last->next;
+            head = last->next;
+            last->next = nullptr;
+            count -= kBatch;
+            global().give({first, kBatch});
+        }
+
+        // Thread exit: everything cached goes back to the global pool, and
+        // later calls on this thread (from other thread_local destructors)
+        // go straight to the global pool
+        ~ThreadCache() {
+            while (count >= kBatch) spill();
+            if (head) global().give({head, count});
+            retired() = true;
+        }
+    };
+
+    static Global& global() {
+        // Never destroyed: blocks may be freed during static destruction
+        static Global* g = new Global;
+        return *g;
+    }
+
+    static ThreadCache& threadCache() {
+        static thread_local ThreadCache cache;
+        return cache;
+    }
+
+    static bool& retired() noexcept {
+        static thread_local bool flag = false; // trivially destructible
+        return flag;
+    }
+};
+
+template<typename T>
+class pool_allocator {
+public:
+    using value_type = T;
+
+    pool_allocator() noexcept = default;
+    template<typename U>
+    pool_allocator(const pool_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n == 1) return static_cast<T*>(pool::allocate());
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (n == 1) pool::deallocate(p);
+        else ::operator delete(p, std::align_val_t(alignof(T)));
+    }
+
+    template<typename U>
+    bool operator==(const pool_allocator<U>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const pool_allocator<U>&) const noexcept { return false; }
+
+private:
+    using pool = fixed_block_pool<sizeof(T), alignof(T)>;
+};
+
+} // namespace smartptrs
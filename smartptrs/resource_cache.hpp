@@ -0,0 +1,643 @@
+/*******************************************************************************
+ * resource_cache.hpp
+ * Weak-reference resource cache with an optional lock-striped concurrent mode
+ *
+ * ResourceCache<T> maps string keys to weak_ptr<T>: it hands out shared
+ * ownership of cached objects but never keeps one alive by itself.
+ *
+ * MODES:
+ *   - SingleThreaded   one shard, no locking (default)
+ *   - Concurrent<N>    N shards selected by key hash, each with its own mutex
+ *                      over a small open-addressing table
+ *
+ * In concurrent mode, simultaneous misses on the same key build exactly one
+ * object: the first caller runs the factory outside the shard lock and the
+ * others wait on that single build and share its result (or its exception).
+ *
+ * Keys are looked up as std::string_view through a transparent hash, so a
+ * hit never materializes a std::string and performs no heap allocation.
+ *
+ * EXPIRED ENTRIES:
+ *   A dead weak_ptr still pins its control block - for make_shared objects
+ *   that is the object's storage too. Every operation sweeps a few slots of
+ *   the shard it locked and drops expired entries, and rehashing discards
+ *   them as well, so dead entries are reclaimed incrementally with no
+ *   whole-cache pause. stats() reports live vs. expired entries.
+ *
+ * STRONG RETENTION TIER (optional):
+ *   With a RetentionPolicy the cache also keeps up to maxEntries recently
+ *   used objects alive (and/or up to maxBytes of them), so a hot resource
+ *   survives its last external owner going away. The budget is global,
+ *   kept in one total for the whole cache, so any object up to maxBytes
+ *   can be retained and hot keys that hash to one shard may use all of
+ *   it. Eviction is CLOCK (second chance) over the shards' rings taken
+ *   end to end: the hand runs through one shard's ring, then moves to the
+ *   next shard. A shard other than the caller's is swept only if its lock
+ *   is free (try_lock), so
+ *   shard locks are never waited on while holding one; if no room can be
+ *   made that way the object just isn't retained this time. An evicted
+ *   entry drops back to weak-only tracking, and is released after the
+ *   shard lock is dropped.
+ *
+ * ASYNC LOADS (Concurrent<N> only):
+ *   getOrCreateAsync(key, pool, make) returns a load_task<T> (async_load.hpp)
+ *   at once and runs make() on the thread_pool. A hit comes back ready;
+ *   requests for a key that is already building, asynchronously or not,
+ *   join that one build. Each requester is tracked weakly, so one that
+ *   cancels (or drops its load_task) doesn't keep the result alive. The
+ *   cache must outlive the loads it started. The factory is copied into a
+ *   pool task, so it must be copy constructible.
+ *
+ * WARM START:
+ *   setMissSource(fn) installs a lookup that every miss consults before the
+ *   factory (fn(key) returning null falls through to make()); forEachLive
+ *   visits the live entries. cache_snapshot.hpp builds a saved, mmapped
+ *   snapshot on these two.
+ *
+ * A factory must not call getOrCreate() for the key it is building.
+ ******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "async_load.hpp"
+#include "diagnostics.hpp"
+#include "sync.hpp"
+#include "thread_pool.hpp"
+
+namespace smartptrs {
+
+struct SingleThreaded {
+    static constexpr std::size_t shards = 1;
+    static constexpr bool concurrent = false;
+    using mutex_type = null_mutex;
+};
+
+// Hashes std::string, std::string_view and const char* identically, so any
+// of them can probe a table whose keys are stored as std::string
+struct KeyHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view key) const noexcept {
+        return std::hash<std::string_view>{}(key);
+    }
+};
+
+struct CacheStats {
+    std::size_t live = 0;     // entries whose object is still alive
+    std::size_t expired = 0;  // dead entries not swept yet
+    std::size_t building = 0; // entries whose factory is running
+    std::uint64_t purged = 0; // dead entries dropped since construction
+
+    // Per-tier lookup counters (since construction)
+    std::uint64_t strongHits = 0; // found in the retention tier
+    std::uint64_t weakHits = 0;   // found alive through weak_ptr only
+    std::uint64_t misses = 0;     // no live object: built, or waited on a build
+    std::uint64_t sourced = 0;    // misses built by the miss source, not the factory
+    std::size_t retained = 0;     // entries held by the retention tier
+    std::size_t retainedBytes = 0;
+    std::uint64_t evictions = 0;  // entries demoted from the retention tier
+};
+
+// Budget for the strong retention tier, for the whole cache (not per
+// shard); maxEntries == 0 disables it
+template<typename T>
+struct RetentionPolicy {
+    std::size_t maxEntries = 0;
+    std::size_t maxBytes = 0; // 0 = limited by maxEntries only
+    std::function<std::size_t(const T&)> charge; // cost in bytes, default sizeof(T)
+};
+
+template<std::size_t N = 16>
+struct Concurrent {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "shard count must be a power of two");
+    static_assert(N <= 65536, "shard index is taken from 16 hash bits");
+    static constexpr std::size_t shards = N;
+    static constexpr bool concurrent = true;
+    using mutex_type = std::mutex;
+};
+
+template<typename T, typename Mode = SingleThreaded>
+class ResourceCache {
+public:
+    ResourceCache() = default;
+    explicit ResourceCache(RetentionPolicy<T> retention)
+        : maxEntries_(retention.maxEntries), maxBytes_(retention.maxBytes),
+          charge_(std::move(retention.charge)) {}
+    ResourceCache(const ResourceCache&) = delete;
+    ResourceCache& operator=(const ResourceCache&) = delete;
+
+    // Returns the cached object for key, or calls make() (which must return
+    // something convertible to shared_ptr<T>) and caches a weak_ptr to it.
+    template<typename Factory>
+    std::shared_ptr<T> getOrCreate(std::string_view key, Factory&& make) {
+        const std::size_t h = hashKey(key);
+        Shard& shard = shardFor(h);
+        Victims victims; // declared first: released after the lock
+        std::unique_lock<mutex_type> lock(shard.mutex);
+        shard.sweep(kSweepPerOp);
+
+        Slot* slot = shard.find(key, h);
+        if (slot && slot->state == State::Ready) {
+            if (auto sp = hit(shard, slot, victims)) return sp;
+            // expired: rebuild in place below
+        } else if (slot && slot->state == State::Building) {
+            if constexpr (!Mode::concurrent) {
+                throw std::logic_error("ResourceCache: factory re-entered its own key");
+            } else {
+                // Someone else is building this key: wait for that build
+                ++shard.misses;
+                std::shared_ptr<Pending> pending = slot->pending;
+                shard.built.wait(lock, [&] { return pending->done; });
+                if (pending->error) std::rethrow_exception(pending->error);
+                return pending->result;
+            }
+        }
+
+        ++shard.misses;
+        if (!slot) slot = shard.insert(key, h);
+        slot->state = State::Building;
+        std::shared_ptr<Pending> pending;
+        if constexpr (Mode::concurrent) {
+            pending = std::make_shared<Pending>();
+            slot->pending = pending;
+        }
+        return build(shard, lock, key, h, pending, victims, std::forward<Factory>(make));
+    }
+
+    // Like getOrCreate, but returns at once: a hit is ready immediately, a
+    // miss runs make() on pool (or joins the build already running for key)
+    template<typename Factory>
+    load_task<T> getOrCreateAsync(std::string_view key, thread_pool& pool, Factory make) {
+        static_assert(Mode::concurrent, "getOrCreateAsync needs a Concurrent<N> cache: loads run on pool threads");
+        const std::size_t h = hashKey(key);
+        Shard& shard = shardFor(h);
+        Victims victims;
+        std::unique_lock<mutex_type> lock(shard.mutex);
+        shard.sweep(kSweepPerOp);
+
+        Slot* slot = shard.find(key, h);
+        if (slot && slot->state == State::Ready) {
+            if (auto sp = hit(shard, slot, victims)) return load_task<T>(std::move(sp));
+        }
+        auto request = std::make_shared<detail::load_request<T>>();
+        ++shard.misses;
+        if (slot && slot->state == State::Building) {
+            slot->pending->requests.push_back(request);
+            return load_task<T>(std::move(request));
+        }
+        if (!slot) slot = shard.insert(key, h);
+        slot->state = State::Building;
+        auto pending = std::make_shared<Pending>();
+        pending->requests.push_back(request);
+        slot->pending = pending;
+        lock.unlock();
+
+        try {
+            pool.submit([this, &shard, owned = std::string(key), h, pending, make]() mutable {
+                Victims evicted;
+                std::unique_lock<mutex_type> relock(shard.mutex);
+                try {
+                    build(shard, relock, owned, h, pending, evicted, std::move(make));
+                } catch (...) {
+                    // delivered to the requesters by build()
+                }
+                pending.reset();
+            });
+        } catch (...) {
+            lock.lock();
+            shard.erase(shard.find(key, h));
+            pending->error = std::current_exception();
+            pending->done = true;
+            lock.unlock();
+            shard.built.notify_all();
+            pending->deliver();
+            throw;
+        }
+        return load_task<T>(std::move(request));
+    }
+
+    // Number of keys tracked (including ones whose object has expired)
+    std::size_t size() const {
+        std::size_t n = 0;
+        for (const Shard& shard : shards_) {
+            std::lock_guard<mutex_type> lock(shard.mutex);
+            n += shard.used;
+        }
+        return n;
+    }
+
+    // Walks all entries, one shard at a time (each under its own lock only)
+    CacheStats stats() const {
+        CacheStats st;
+        for (const Shard& shard : shards_) {
+            std::lock_guard<mutex_type> lock(shard.mutex);
+            for (const Slot& s : shard.slots) {
+                if (s.state == State::Building) ++st.building;
+                else if (s.state == State::Ready) ++(s.value.expired() ? st.expired : st.live);
+            }
+            st.purged += shard.purged;
+            st.strongHits += shard.strongHits;
+            st.weakHits += shard.weakHits;
+            st.misses += shard.misses;
+            st.sourced += shard.sourced;
+            st.retained += shard.ring.size();
+            st.retainedBytes += shard.ringBytes;
+            st.evictions += shard.evictions;
+        }
+        return st;
+    }
+
+    // Calls fn(key, object) for every live entry, one shard at a time; fn
+    // runs with no shard lock held
+    template<typename Fn>
+    void forEachLive(Fn&& fn) const {
+        std::vector<std::pair<std::string, std::shared_ptr<T>>> batch;
+        for (const Shard& shard : shards_) {
+            batch.clear();
+            {
+                std::lock_guard<mutex_type> lock(shard.mutex);
+                for (const Slot& s : shard.slots) {
+                    if (s.state != State::Ready) continue;
+                    if (auto sp = s.value.lock()) batch.emplace_back(s.key, std::move(sp));
+                }
+            }
+            for (const auto& entry : batch) fn(std::string_view(entry.first), entry.second);
+        }
+    }
+
+    // Consulted on every miss before the factory: a non-null result is
+    // cached instead of calling make(). Set it before the cache is shared
+    // between threads; it is read without locking.
+    using miss_source = std::function<std::shared_ptr<T>(std::string_view key)>;
+    void setMissSource(miss_source source) { missSource_ = std::move(source); }
+
+    // Empties the retention tier (e.g. under memory pressure); entries stay
+    // tracked weakly
+    void releaseRetained() {
+        for (Shard& shard : shards_) {
+            Victims victims;
+            std::lock_guard<mutex_type> lock(shard.mutex);
+            for (Retained& r : shard.ring) {
+                shard.slots[r.slot].retained = kNotRetained;
+                victims.push_back(std::move(r.object));
+            }
+            shard.evictions += shard.ring.size();
+            retainedEntries_ -= shard.ring.size();
+            retainedBytes_ -= shard.ringBytes;
+            shard.ring.clear();
+            shard.ringBytes = 0;
+            shard.hand = 0;
+        }
+    }
+
+    // Sweeps up to slotsPerShard slots of every shard, continuing where the
+    // previous sweep stopped. Returns the number of entries dropped. Useful
+    // from an idle hook; regular operations already sweep a little each.
+    std::size_t purgeExpired(std::size_t slotsPerShard) {
+        std::size_t n = 0;
+        for (Shard& shard : shards_) {
+            std::lock_guard<mutex_type> lock(shard.mutex);
+            n += shard.sweep(slotsPerShard);
+        }
+        return n;
+    }
+
+    static constexpr std::size_t shardCount() { return Mode::shards; }
+
+private:
+    // Slots examined for expiry on every getOrCreate (bounded, amortized)
+    static constexpr std::size_t kSweepPerOp = 2;
+    static constexpr std::size_t kNotRetained = static_cast<std::size_t>(-1);
+
+    // Strong references dropped by eviction, destroyed outside the lock
+    using Victims = std::vector<std::shared_ptr<T>>;
+
+    // Retention totals across shards; each entry's share is added and
+    // removed under the lock of the shard that holds it
+    using counter_type = std::conditional_t<Mode::concurrent, std::atomic<std::size_t>, std::size_t>;
+
+    using mutex_type = typename Mode::mutex_type;
+
+    // Shared by the builder and every caller waiting on the same key
+    struct Pending {
+        std::shared_ptr<T> result;
+        std::exception_ptr error;
+        bool done = false;
+        // getOrCreateAsync requesters; weak so cancelled ones hold nothing
+        std::vector<std::weak_ptr<detail::load_request<T>>> requests;
+
+        // Hands the outcome to every requester still waiting (no lock held)
+        void deliver() const noexcept {
+            for (const auto& weak : requests) {
+                if (auto request = weak.lock()) request->complete(result, error);
+            }
+        }
+    };
+
+    enum class State : unsigned char { Empty, Deleted, Building, Ready };
+
+    struct Slot {
+        std::size_t hash = 0;
+        State state = State::Empty;
+        std::string key;
+        std::weak_ptr<T> value;
+        std::shared_ptr<Pending> pending; // set only while Building (concurrent)
+        std::size_t retained = kNotRetained; // index into Shard::ring
+        bool referenced = false;             // CLOCK reference bit
+    };
+
+    struct Retained {
+        std::shared_ptr<T> object;
+        std::size_t slot; // index into Shard::slots, kept in sync by rehash
+        std::size_t bytes;
+    };
+
+    struct no_condition {};
+    using condition_type = std::conditional_t<Mode::concurrent,
+                                              std::condition_variable, no_condition>;
+
+    // Open-addressing table with linear probing. Capacity is a power of two
+    // and (used + tombstones) stays below 3/4 of it, so probes always end.
+    struct alignas(64) Shard {
+        mutable mutex_type mutex;
+        condition_type built;
+        std::vector<Slot> slots;
+        std::size_t used = 0;       // Building + Ready slots
+        std::size_t tombstones = 0; // Deleted slots
+        std::size_t cursor = 0;     // next slot for sweep()
+        std::uint64_t purged = 0;
+        std::uint64_t strongHits = 0;
+        std::uint64_t weakHits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t sourced = 0;
+        std::uint64_t evictions = 0;
+
+        std::vector<Retained> ring; // CLOCK ring of the retention tier
+        std::size_t hand = 0;
+        std::size_t ringBytes = 0;
+
+        Slot* find(std::string_view key, std::size_t h) {
+            if (slots.empty()) return nullptr;
+            const std::size_t mask = slots.size() - 1;
+            for (std::size_t i = h & mask;; i = (i + 1) & mask) {
+                Slot& s = slots[i];
+                if (s.state == State::Empty) return nullptr;
+                if (s.state != State::Deleted && s.hash == h && s.key == key) return &s;
+            }
+        }
+
+        // key must not be present
+        Slot* insert(std::string_view key, std::size_t h) {
+            if ((used + tombstones + 1) * 4 > slots.size() * 3) rehash(used + 1);
+            const std::size_t mask = slots.size() - 1;
+            std::size_t i = h & mask;
+            while (slots[i].state != State::Empty && slots[i].state != State::Deleted) {
+                i = (i + 1) & mask;
+            }
+            Slot& s = slots[i];
+            if (s.state == State::Deleted) --tombstones;
+            s.hash = h;
+            s.key.assign(key.data(), key.size());
+            ++used;
+            return &s;
+        }
+
+        void erase(Slot* s) {
+            s->state = State::Deleted;
+            std::string().swap(s->key);
+            s->value.reset();
+            s->pending.reset();
+            --used;
+            ++tombstones;
+        }
+
+        // Drops expired entries among the next n slots
+        std::size_t sweep(std::size_t n) {
+            if (slots.empty()) return 0;
+            const std::size_t mask = slots.size() - 1;
+            std::size_t dropped = 0;
+            for (n = std::min(n, slots.size()); n > 0; --n) {
+                Slot& s = slots[cursor];
+                cursor = (cursor + 1) & mask;
+                if (s.state == State::Ready && s.value.expired()) {
+                    erase(&s);
+                    ++dropped;
+                }
+            }
+            purged += dropped;
+            return dropped;
+        }
+
+        // Rebuilds the table for roughly `needed` entries, discarding
+        // tombstones and expired entries. May grow or shrink.
+        void rehash(std::size_t needed) {
+            std::size_t capacity = 8;
+            while (capacity < needed * 2) capacity *= 2;
+            std::vector<Slot> old(capacity);
+            old.swap(slots);
+            used = 0;
+            tombstones = 0;
+            cursor = 0;
+            const std::size_t mask = capacity - 1;
+            for (Slot& s : old) {
+                const bool keep = s.state == State::Building ||
+                                  (s.state == State::Ready && !s.value.expired());
+                if (!keep) {
+                    if (s.state == State::Ready) ++purged;
+                    continue;
+                }
+                ++used;
+                std::size_t i = s.hash & mask;
+                while (slots[i].state != State::Empty) i = (i + 1) & mask;
+                if (s.retained != kNotRetained) ring[s.retained].slot = i;
+                slots[i] = std::move(s);
+            }
+        }
+    };
+
+    // Runs the factory with the shard unlocked, then publishes the result.
+    // The table may rehash meanwhile, so the slot is looked up again.
+    template<typename Factory>
+    std::shared_ptr<T> build(Shard& shard, std::unique_lock<mutex_type>& lock,
+                             std::string_view key, std::size_t h,
+                             const std::shared_ptr<Pending>& pending, Victims& victims,
+                             Factory&& make) {
+        lock.unlock();
+        std::shared_ptr<T> sp;
+        bool sourced = false;
+        try {
+            alloc_site site("ResourceCache::getOrCreate");
+            if (missSource_) sourced = static_cast<bool>(sp = missSource_(key));
+            if (!sourced) sp = std::forward<Factory>(make)();
+        } catch (...) {
+            lock.lock();
+            shard.erase(shard.find(key, h));
+            if constexpr (Mode::concurrent) {
+                pending->error = std::current_exception();
+                pending->done = true;
+                lock.unlock();
+                shard.built.notify_all();
+                pending->deliver();
+            }
+            throw;
+        }
+        lock.lock();
+        if (sourced) ++shard.sourced;
+        Slot* slot = shard.find(key, h);
+        slot->value = sp;
+        slot->state = State::Ready;
+        if (sp) retain(shard, slot, sp, victims);
+        if constexpr (Mode::concurrent) {
+            slot->pending.reset();
+            pending->result = sp;
+            pending->done = true;
+            lock.unlock();
+            shard.built.notify_all();
+            pending->deliver();
+        }
+        return sp;
+    }
+
+    // A live Ready slot: returns its object and updates the tiers, or null
+    // if it has expired
+    std::shared_ptr<T> hit(Shard& shard, Slot* slot, Victims& victims) {
+        auto sp = slot->value.lock();
+        if (!sp) return sp;
+        if (slot->retained != kNotRetained) {
+            slot->referenced = true;
+            ++shard.strongHits;
+        } else {
+            ++shard.weakHits;
+            retain(shard, slot, sp, victims);
+        }
+        return sp;
+    }
+
+    // Admits a live object into the shard's CLOCK ring once the global
+    // budget has room for it, evicting until it does. Gives up (leaving the
+    // object weak-only) if the visits run out because other shards stayed
+    // locked
+    void retain(Shard& shard, Slot* slot, const std::shared_ptr<T>& sp, Victims& victims) {
+        if (maxEntries_ == 0) return;
+        const std::size_t bytes = charge_ ? charge_(*sp) : sizeof(T);
+        if (maxBytes_ && bytes > maxBytes_) return;
+
+        // Two passes over every shard (clearing reference bits, then
+        // evicting) plus one visit per eviction, at most maxEntries
+        std::size_t visits = maxEntries_ + 3 * Mode::shards;
+        while (!reserve(bytes)) {
+            if (visits-- == 0) return;
+            Shard& victim = shards_[victimCursor_ % Mode::shards];
+            bool evicted = false;
+            if (&victim == &shard) {
+                evicted = clockSweep(shard, victims);
+            } else {
+                std::unique_lock<mutex_type> other(victim.mutex, std::try_to_lock);
+                if (other) evicted = clockSweep(victim, victims);
+            }
+            if (!evicted) ++victimCursor_; // hand moves on to the next shard
+        }
+
+        slot->retained = shard.ring.size();
+        slot->referenced = false;
+        shard.ring.push_back({sp, static_cast<std::size_t>(slot - shard.slots.data()), bytes});
+        shard.ringBytes += bytes;
+    }
+
+    // Takes room for one more retained entry of `bytes` from the totals
+    bool reserve(std::size_t bytes) {
+        if (!addWithin(retainedEntries_, 1, maxEntries_)) return false;
+        if (!addWithin(retainedBytes_, bytes, maxBytes_ ? maxBytes_ : static_cast<std::size_t>(-1))) {
+            retainedEntries_ -= 1;
+            return false;
+        }
+        return true;
+    }
+
+    static bool addWithin(counter_type& total, std::size_t n, std::size_t limit) {
+        if constexpr (Mode::concurrent) {
+            std::size_t current = total.load(std::memory_order_relaxed);
+            do {
+                if (n > limit - current) return false;
+            } while (!total.compare_exchange_weak(current, current + n, std::memory_order_relaxed));
+        } else {
+            if (n > limit - total) return false;
+            total += n;
+        }
+        return true;
+    }
+
+    // Advances a locked shard's hand, clearing reference bits, up to the
+    // first entry whose bit was already clear and evicts it. Returns false
+    // (and rewinds the hand) if it reached the end of the ring instead
+    bool clockSweep(Shard& shard, Victims& victims) {
+        Retained* found = nullptr;
+        for (; shard.hand < shard.ring.size(); ++shard.hand) {
+            Slot& owner = shard.slots[shard.ring[shard.hand].slot];
+            if (!owner.referenced) {
+                found = &shard.ring[shard.hand];
+                break;
+            }
+            owner.referenced = false; // second chance
+        }
+        if (!found) {
+            shard.hand = 0;
+            return false;
+        }
+        Retained& r = *found;
+        Slot& owner = shard.slots[r.slot];
+        owner.retained = kNotRetained;
+        shard.ringBytes -= r.bytes;
+        retainedEntries_ -= 1;
+        retainedBytes_ -= r.bytes;
+        victims.push_back(std::move(r.object));
+        if (&r != &shard.ring.back()) {
+            r = std::move(shard.ring.back());
+            shard.slots[r.slot].retained = shard.hand;
+        }
+        shard.ring.pop_back();
+        ++shard.evictions;
+        return true;
+    }
+
+    static std::size_t hashKey(std::string_view key) {
+        // Finalizer from MurmurHash3: spreads KeyHash bits so both the shard
+        // index (high bits) and the slot index (low bits) are well mixed
+        std::uint64_t h = KeyHash{}(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<std::size_t>(h);
+    }
+
+    Shard& shardFor(std::size_t h) {
+        return shards_[(h >> (sizeof(std::size_t) * 8 - 16)) & (Mode::shards - 1)];
+    }
+
+    std::size_t maxEntries_ = 0;
+    std::size_t maxBytes_ = 0;
+    counter_type retainedEntries_{0};
+    counter_type retainedBytes_{0};
+    counter_type victimCursor_{0}; // next shard for retain() to step
+    std::function<std::size_t(const T&)> charge_;
+    miss_source missSource_;
+    Shard shards_[Mode::shards];
+};
+
+} // namespace smartptrs
@@ -0,0 +1,37 @@
+/*******************************************************************************
+ * retired.hpp
+ * Type-erased "destroy this later" node shared by the reclaimers
+ *
+ * epoch_reclaimer and hazard_reclaimer both accept retire(ptr, deleter)
+ * with any deleter a unique_ptr would take (default_delete, FileCloser,
+ * a lambda, a pool's recycler). The pointer and deleter are moved into a
+ * retired_object whose destructor runs the deleter; reclaimers chain the
+ * nodes through `next` and delete them once the pointer is unreachable.
+ ******************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+namespace smartptrs {
+namespace detail {
+
+struct retired_node {
+    virtual ~retired_node() = default;
+
+    const void* address = nullptr; // what readers may still hold
+    std::uint64_t epoch = 0;       // epoch_reclaimer only
+    retired_node* next = nullptr;
+};
+
+template<typename T, typename Deleter>
+struct retired_object final : retired_node {
+    retired_object(T* p, Deleter d) : ptr(p), deleter(std::move(d)) { address = p; }
+    ~retired_object() override { deleter(ptr); }
+
+    T* ptr;
+    Deleter deleter;
+};
+
+} // namespace detail
+} // namespace smartptrs
@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * slot_map.hpp
+ * Contiguous object storage addressed by generational handles
+ *
+ * vector<unique_ptr<Widget>> puts every Widget in its own heap block, so
+ * iterating is a pointer chase per element. slot_map<T> keeps the values
+ * packed in one array and gives out small {index, generation} handles that
+ * behave like weak references:
+ *
+ *   smartptrs::slot_map<Widget> widgets;
+ *   auto h = widgets.insert(1, "first");
+ *   for (Widget& w : widgets) w.greet();      // contiguous scan
+ *   widgets.erase(h);
+ *   widgets.expired(h);                       // true, like weak_ptr::expired
+ *   widgets.get(h);                           // nullptr, like weak_ptr::lock
+ *
+ * LAYOUT:
+ *   - values are dense: erase moves the last value into the hole, so the
+ *     array never has gaps (iteration order is not insertion order)
+ *   - each handle names a slot; a slot holds the value's dense index and a
+ *     generation that erase() bumps, so handles to an erased value fail
+ *     even after the slot is reused
+ *   - freed slots are reused LIFO; lookups are one indexed load plus a
+ *     generation compare
+ *
+ * Pointers and references to values are invalidated by insert and erase
+ * (use handles across those). A slot's generation wraps after 2^32 reuses.
+ ******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace smartptrs {
+
+template<typename T>
+class slot_map {
+public:
+    struct handle {
+        std::uint32_t index = kNone;
+        std::uint32_t generation = 0;
+
+        friend bool operator==(handle a, handle b) noexcept {
+            return a.index == b.index && a.generation == b.generation;
+        }
+        friend bool operator!=(handle a, handle b) noexcept { return !(a == b); }
+    };
+
+    using value_type = T;
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    template<typename... Args>
+    handle insert(Args&&... args) {
+        // Each step either succeeds or leaves the map unchanged
+        if (freeHead_ == kNone) {
+            slots_.push_back({});
+            freeHead_ = std::uint32_t(slots_.size() - 1);
+        }
+        const std::uint32_t slot = freeHead_;
+        values_.emplace_back(std::forward<Args>(args)...);
+        try {
+            denseToSlot_.push_back(slot);
+        } catch (...) {
+            values_.pop_back();
+            throw;
+        }
+        freeHead_ = slots_[slot].index;
+        slots_[slot].index = std::uint32_t(values_.size() - 1);
+        return {slot, slots_[slot].generation};
+    }
+
+    // Destroys the value h refers to; false if h has expired
+    bool erase(handle h) {
+        if (expired(h)) return false;
+        Slot& slot = slots_[h.index];
+        const std::uint32_t dense = slot.index;
+        const std::uint32_t last = std::uint32_t(values_.size() - 1);
+        if (dense != last) {
+            values_[dense] = std::move(values_[last]);
+            denseToSlot_[dense] = denseToSlot_[last];
+            slots_[denseToSlot_[dense]].index = dense;
+        }
+        values_.pop_back();
+        denseToSlot_.pop_back();
+        ++slot.generation;
+        slot.index = freeHead_;
+        freeHead_ = h.index;
+        return true;
+    }
+
+    bool expired(handle h) const noexcept {
+        return h.index >= slots_.size() || slots_[h.index].generation != h.generation;
+    }
+
+    // The value h refers to, or nullptr once it has been erased
+    T* get(handle h) noexcept { return expired(h) ? nullptr : &values_[slots_[h.index].index]; }
+    const T* get(handle h) const noexcept {
+        return expired(h) ? nullptr : &values_[slots_[h.index].index];
+    }
+
+    T& at(handle h) {
+        if (T* p = get(h)) return *p;
+        throw std::out_of_range("slot_map: expired handle");
+    }
+    const T& at(handle h) const {
+        if (const T* p = get(h)) return *p;
+        throw std::out_of_range("slot_map: expired handle");
+    }
+
+    // Handle of the value at dense position i (e.g. while iterating)
+    handle handleAt(std::size_t i) const noexcept {
+        const std::uint32_t slot = denseToSlot_[i];
+        return {slot, slots_[slot].generation};
+    }
+
+    void reserve(std::size_t n) {
+        values_.reserve(n);
+        denseToSlot_.reserve(n);
+        slots_.reserve(n);
+    }
+
+    // Erases everything; every outstanding handle expires
+    void clear() {
+        while (!values_.empty()) erase(handleAt(values_.size() - 1));
+    }
+
+    std::size_t size() const noexcept { return values_.size(); }
+    bool empty() const noexcept { return values_.empty(); }
+
+    iterator begin() noexcept { return values_.begin(); }
+    iterator end() noexcept { return values_.end(); }
+    const_iterator begin() const noexcept { return values_.begin(); }
+    const_iterator end() const noexcept { return values_.end(); }
+    T* data() noexcept { return values_.data(); }
+    const T* data() const noexcept { return values_.data(); }
+
+private:
+    static constexpr std::uint32_t kNone = ~std::uint32_t(0);
+
+    struct Slot {
+        std::uint32_t index = kNone; // dense index while live, next free slot while free
+        std::uint32_t generation = 0;
+    };
+
+    std::vector<T> values_;
+    std::vector<std::uint32_t> denseToSlot_;
+    std::vector<Slot> slots_;
+    std::uint32_t freeHead_ = kNone;
+};
+
+} // namespace smartptrs
@@ -11,67 +11,107 @@
  * 
  * 2. Memory Management Patterns
  *    - Cyclic reference problems and solutions
+ *    - Cycle-collected gc_ptr with budgeted trial deletion (gc_ptr.hpp)
  *    - Custom deleters for resource management
  *    - RAII (Resource Acquisition Is Initialization)
+ *    - Deferred deleters that close on a background thread (deferred_delete.hpp)
+ *    - One-word handles for FILE* and fds with a compile-time close (unique_resource.hpp)
+ *    - Buffered and mmap-backed log writers that own their file (file_writer.hpp)
+ *    - Monotonic arena for batch-scoped graphs (arena.hpp)
  * 
  * 3. Advanced Modern C++ Features
  *    - Perfect forwarding and variadic templates
+ *    - Factory registry with a compile-time perfect hash (factory_registry.hpp)
  *    - enable_shared_from_this pattern
  *    - Aliasing constructor
+ *    - Structure-of-arrays WidgetStore with SIMD id queries (widget_store.hpp)
  *    - Observer pattern with weak_ptr
+ *    - Lock-free snapshot observer list (subject.hpp, epoch.hpp)
+ *    - Parallel/async notification on a work-stealing pool (thread_pool.hpp)
+ *    - Sharded concurrent resource cache (resource_cache.hpp)
+ *    - Async getOrCreate with shared in-flight loads (async_load.hpp)
+ *    - mmapped cache snapshots for warm start (cache_snapshot.hpp)
  *    - Polymorphic deletion
+ *    - Small-buffer polymorphic values instead of unique_ptr<Base> (poly_value.hpp)
  *    - Move semantics with smart pointers
+ *    - Bulk factories: make_shared_array, make_shared_batch (batch_make.hpp)
+ *    - Object pool with a recycling unique_ptr deleter (object_pool.hpp)
+ *    - Contiguous storage with generational handles (slot_map.hpp)
  * 
  * 4. Performance & Best Practices
+ *    - atomic_shared_slot for hot-swapped configuration (atomic_slot.hpp)
+ *    - Hazard pointers and retire(ptr, deleter) (hazard.hpp)
+ *    - intrusive_ptr with in-object counts (intrusive_ptr.hpp)
+ *    - local_shared_ptr with non-atomic counts (local_shared_ptr.hpp)
+ *    - borrowed_ptr parameters and captures without ref-counting (borrowed_ptr.hpp)
+ *    - biased_ptr: non-atomic counts on the creating thread (biased_ptr.hpp)
+ *    - make_shared_padded: counts and object on separate cache lines (padded_shared.hpp)
+ *    - Compile-time trace policies for demo types (trace.hpp, demo_types.hpp)
+ *    - Leak and cycle report in -DSMARTPTRS_DIAGNOSTICS builds (diagnostics.hpp)
  *    - make_unique/make_shared vs new
- *    - allocate_shared for custom allocators
+ *    - allocate_shared for custom allocators (pool_allocator.hpp)
  *    - Common pitfalls and how to avoid them
  * 
  * Build: g++ -std=c++17 smartptr.cpp -o smartptr
  * Run:   ./smartptr
+ * Leak report: add -DSMARTPTRS_DIAGNOSTICS (and -rdynamic for frame names)
  ******************************************************************************/
 
 #include <iostream>
 #include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <array>
 #include <map>
 #include <functional>
 #include <algorithm>
 #include <cstdio>
+#include <cstdint>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <chrono>
 
+#include "arena.hpp"
+#include "async_load.hpp"
+#include "atomic_slot.hpp"
+#include "batch_make.hpp"
+#include "biased_ptr.hpp"
+#include "borrowed_ptr.hpp"
+#include "cache_snapshot.hpp"
+#include "deferred_delete.hpp"
+#include "demo_types.hpp"
+#include "diagnostics.hpp"
+#include "factory_registry.hpp"
+#include "file_writer.hpp"
+#include "gc_ptr.hpp"
+#include "hazard.hpp"
+#include "intrusive_ptr.hpp"
+#include "local_shared_ptr.hpp"
+#include "object_pool.hpp"
+#include "padded_shared.hpp"
+#include "poly_value.hpp"
+#include "pool_allocator.hpp"
+#include "resource_cache.hpp"
+#include "slot_map.hpp"
+#include "subject.hpp"
+#include "trace.hpp"
+#include "unique_resource.hpp"
+#include "widget_store.hpp"
+
 using namespace std;
 
 //=============================================================================
 // HELPER CLASSES FOR DEMONSTRATIONS
 //=============================================================================
 
-struct Widget {
-    int id;
-    string name;
-    
-    Widget(int i, string n = "") : id(i), name(move(n)) {
-        cout << "Widget(" << id << ") constructed";
-        if (!name.empty()) cout << ": " << name;
-        cout << '\n';
-    }
-    
-    ~Widget() {
-        cout << "Widget(" << id << ") destroyed";
-        if (!name.empty()) cout << ": " << name;
-        cout << '\n';
-    }
-    
-    void greet() const { 
-        cout << "Widget(" << id << ") says hello";
-        if (!name.empty()) cout << ": " << name;
-        cout << '\n';
-    }
-};
+// The demo types live in demo_types.hpp, templated on a trace policy.
+// Here they print every construction/destruction; benchmarks use the same
+// types with smartptrs::no_trace, which compiles the logging away.
+using DemoTrace = smartptrs::stream_trace;
+
+using Widget = smartptrs::BasicWidget<DemoTrace>;
 
 //=============================================================================
 // 1. BASIC SMART POINTERS
@@ -140,19 +180,9 @@ void sharedPtrExample() {
 }
 
 // Simple cycle demonstration
-struct NodeShared {
-    int value;
-    shared_ptr<NodeShared> next;
-    NodeShared(int v) : value(v) { cout << "NodeShared(" << value << ") constructed\n"; }
-    ~NodeShared() { cout << "NodeShared(" << value << ") destroyed\n"; }
-};
-
-struct NodeWeak {
-    int value;
-    weak_ptr<NodeWeak> next; // weak pointer breaks cycle
-    NodeWeak(int v) : value(v) { cout << "NodeWeak(" << value << ") constructed\n"; }
-    ~NodeWeak() { cout << "NodeWeak(" << value << ") destroyed\n"; }
-};
+using NodeShared = smartptrs::BasicNodeShared<DemoTrace>;
+using NodeWeak = smartptrs::BasicNodeWeak<DemoTrace>; // weak next breaks the cycle
+using GcNode = smartptrs::BasicGcNode<DemoTrace>;     // gc_ptr next, cycles collected
 
 void cycleDemo() {
     cout << "\n--- Cyclic Reference Problem & Solution ---\n";
@@ -167,6 +197,10 @@ void cycleDemo() {
         cout << "Cycle created. Destructors will NOT be called!\n";
     }
     cout << "Memory leak occurred (check: no destructors above)\n";
+    if constexpr (smartptrs::diagnostics::enabled) {
+        cout << "Diagnostics: " << smartptrs::diagnostics::live<NodeShared>()
+             << " NodeShared alive (listed as a cycle in the exit report)\n";
+    }
 
     // SOLUTION: Use weak_ptr to break the cycle
     cout << "\nGOOD: Using weak_ptr breaks the cycle:\n";
@@ -177,6 +211,45 @@ void cycleDemo() {
         b->next = a;  // No strong reference cycle
         cout << "weak_ptr used. Destructors will be called properly.\n";
     }
+
+    // ALTERNATIVE: keep both edges strong and let the cycle collector
+    // (gc_ptr.hpp) find the cycle, when its location isn't known up front
+    cout << "\nGOOD: gc_ptr cycle freed by the collector:\n";
+    {
+        auto a = smartptrs::make_gc<GcNode>(50);
+        auto b = smartptrs::make_gc<GcNode>(60);
+        a->next = b;
+        b->next = a; // same cycle as above
+    }
+    cout << "Cycle unreachable, pending roots: " << smartptrs::gc_heap::stats().pendingRoots << '\n';
+    const size_t freed = smartptrs::gc_heap::collect(); // ~GcNode runs here
+    cout << "gc_heap::collect() freed " << freed << " objects\n";
+}
+
+// Arena-scoped graphs (arena.hpp): nodes are bump-allocated and freed
+// together at reset(), so raw-pointer cycles cost nothing and can't leak
+using ArenaNode = smartptrs::BasicArenaNode<DemoTrace>;
+
+void arenaExample() {
+    cout << "\n--- Monotonic Arena for Batch-Scoped Graphs ---\n";
+    smartptrs::monotonic_arena arena;
+    
+    ArenaNode* a = arena.create<ArenaNode>(50);
+    ArenaNode* b = arena.create<ArenaNode>(60);
+    a->next = b;
+    b->next = a; // cycle is fine: the arena owns both nodes
+    cout << "Recorded destructors: " << arena.pendingDestructors() << '\n';
+    
+    {
+        // unique_ptr-compatible handle: ~Widget runs when it drops,
+        // the memory is reclaimed with everything else at reset()
+        smartptrs::arena_ptr<Widget> w = arena.make<Widget>(70, "arena");
+        w->greet();
+    }
+    
+    arena.reset(); // runs ~ArenaNode newest first: 60, then 50
+    cout << "After reset: " << arena.bytesUsed() << " bytes in use, "
+         << arena.chunkCount() << " chunk kept for the next batch\n";
 }
 
 void weakPtrExample() {
@@ -216,38 +289,38 @@ template<typename T, typename... Args>
 unique_ptr<T> makeWidget(Args&&... args) {
     // forward<> preserves lvalue/rvalue-ness - enables perfect forwarding
     // This is a common factory pattern in modern C++
+    smartptrs::alloc_site site("makeWidget"); // names it in diagnostics builds
     return make_unique<T>(forward<Args>(args)...);
 }
 
 // Factory pattern returning polymorphic types
-struct Shape {
+struct Shape : smartptrs::tracked<Shape> {
     virtual ~Shape() = default;
     virtual void draw() const = 0;
 };
 
 struct Circle : Shape {
+    static constexpr string_view kFactoryName = "circle";
     void draw() const override { cout << "Drawing Circle\n"; }
 };
 
 struct Square : Shape {
+    static constexpr string_view kFactoryName = "square";
     void draw() const override { cout << "Drawing Square\n"; }
 };
 
-unique_ptr<Shape> createShape(const string& type) {
-    if (type == "circle") return make_unique<Circle>();
-    if (type == "square") return make_unique<Square>();
-    return nullptr;
+// Names -> types through a compile-time perfect hash (factory_registry.hpp)
+// instead of one string compare per type
+using ShapeRegistry = smartptrs::factory_registry<Shape, Circle, Square>;
+
+unique_ptr<Shape> createShape(string_view type) {
+    smartptrs::alloc_site site("createShape");
+    return ShapeRegistry::create(type);
 }
 
 // enable_shared_from_this - get shared_ptr from 'this'
-struct Component : enable_shared_from_this<Component> {
-    int id;
-    Component(int i) : id(i) { cout << "Component(" << id << ") created\n"; }
-    ~Component() { cout << "Component(" << id << ") destroyed\n"; }
-    
-    // Can safely return shared_ptr to self
-    shared_ptr<Component> getPtr() { return shared_from_this(); }
-};
+// (Component::getPtr() returns shared_from_this())
+using Component = smartptrs::BasicComponent<DemoTrace>;
 
 void advancedFeatures() {
     cout << "\n--- Advanced Modern C++ Features ---\n";
@@ -261,6 +334,10 @@ void advancedFeatures() {
     auto shape2 = createShape("square");
     if (shape1) shape1->draw();
     if (shape2) shape2->draw();
+    // Same lookup, object in a fixed_block_pool block sized for the largest shape
+    ShapeRegistry::pooled_ptr pooled = ShapeRegistry::createPooled("square");
+    pooled->draw();
+    cout << "Unknown shape gives nullptr: " << (createShape("hexagon") == nullptr) << '\n';
     
     // enable_shared_from_this usage
     auto comp = make_shared<Component>(200);
@@ -271,16 +348,36 @@ void advancedFeatures() {
     auto widget = make_shared<Widget>(300, "alias-test");
     shared_ptr<int> idPtr(widget, &widget->id); // shares ownership but points to id
     cout << "Aliased id: " << *idPtr << " (use_count=" << idPtr.use_count() << ")\n";
+
+    // Same idea over a structure-of-arrays store: ids sit in their own
+    // array for SIMD scans, and each entry is handed out as an alias
+    auto store = smartptrs::WidgetStore::create(64);
+    for (int id = 310; id < 320; ++id) store->add(id, "soa");
+    store->erase(store->findId(312));
+    vector<size_t> inRange;
+    store->filterIdRange(311, 314, inRange);
+    shared_ptr<int> storedId = store->idPtr(store->findId(313));
+    cout << "WidgetStore (" << smartptrs::WidgetStore::simdBackend() << "): " << store->countLive()
+         << " live, " << inRange.size() << " in [311, 314], aliased id " << *storedId << "\n";
     
     // 4. Array support (C++17+)
     shared_ptr<Widget[]> arr(new Widget[2]{{400, "arr[0]"}, {401, "arr[1]"}});
     arr[0].greet();
     arr[1].greet();
     cout << "Array will auto-delete[] on destruction\n";
+    // make_shared_array (batch_make.hpp): elements and control block share
+    // one allocation, like C++20 make_shared<T[]>(n); _for_overwrite skips
+    // the zeroing when the elements are about to be written anyway
+    shared_ptr<int[]> counts = smartptrs::make_shared_array<int>(4);
+    unique_ptr<char[]> scratch = smartptrs::make_unique_for_overwrite<char[]>(64);
+    scratch[0] = '\0';
+    cout << "make_shared_array<int>(4): counts[3] = " << counts[3] << " (value-initialized)\n";
     
     // 5. Custom allocator (allocate_shared for efficiency)
-    auto w2 = allocate_shared<Widget>(allocator<Widget>(), 500, "allocated");
-    cout << "allocate_shared reduces allocations vs make_shared\n";
+    // allocate_shared rebinds the allocator to its fused control block +
+    // Widget type, so the pool serves exactly that block size
+    auto w2 = allocate_shared<Widget>(smartptrs::pool_allocator<Widget>(), 500, "allocated");
+    cout << "allocate_shared with pool_allocator: block comes from a per-thread free list\n";
     
     // unique_ptr can be converted to shared_ptr
     unique_ptr<Widget> unique_w = make_unique<Widget>(600, "converted");
@@ -289,36 +386,95 @@ void advancedFeatures() {
 }
 
 // 6. Resource cache using weak_ptr (avoids keeping objects alive)
-class ResourceCache {
-    map<string, weak_ptr<Widget>> cache;
-public:
-    shared_ptr<Widget> getOrCreate(const string& key, int id) {
-        auto it = cache.find(key);
-        if (it != cache.end()) {
-            if (auto sp = it->second.lock()) {
-                cout << "Cache hit: " << key << "\n";
-                return sp;
-            }
-        }
+// smartptrs::ResourceCache (resource_cache.hpp) stores weak_ptrs, so the cache
+// never extends a resource's lifetime. The factory only runs on a miss.
+// Lookups take string_view: a hit neither builds a string nor allocates.
+template<typename Mode>
+shared_ptr<Widget> loadWidget(smartptrs::ResourceCache<Widget, Mode>& cache,
+                              string_view key, int id) {
+    bool miss = false;
+    auto sp = cache.getOrCreate(key, [&] {
+        miss = true;
         cout << "Cache miss: creating " << key << "\n";
-        auto sp = make_shared<Widget>(id, key);
-        cache[key] = sp;
-        return sp;
-    }
-};
+        return make_shared<Widget>(id, string(key));
+    });
+    if (!miss) cout << "Cache hit: " << key << "\n";
+    return sp;
+}
 
 void resourceCacheExample() {
     cout << "\n--- Resource Cache with weak_ptr ---\n";
-    ResourceCache cache;
+    smartptrs::ResourceCache<Widget> cache;
     
     {
-        auto res1 = cache.getOrCreate("texture_1", 100);
-        auto res2 = cache.getOrCreate("texture_1", 100); // Cache hit
+        auto res1 = loadWidget(cache, "texture_1", 100);
+        auto res2 = loadWidget(cache, "texture_1", 100); // Cache hit
         cout << "Both references active. use_count: " << res1.use_count() << "\n";
     }
     
-    // After scope, resources destroyed
-    auto res3 = cache.getOrCreate("texture_1", 100); // Cache miss (expired)
+    // After scope, resources destroyed. The dead entry is swept lazily.
+    auto st = cache.stats();
+    cout << "Entries: live=" << st.live << " expired=" << st.expired << "\n";
+    auto res3 = loadWidget(cache, "texture_1", 100); // Cache miss (expired)
+    
+    // Retention tier: keep the 2 most recently used Widgets alive (CLOCK),
+    // so a hot resource survives its last user going away
+    smartptrs::RetentionPolicy<Widget> keepTwo;
+    keepTwo.maxEntries = 2;
+    smartptrs::ResourceCache<Widget> retaining(keepTwo);
+    loadWidget(retaining, "texture_1", 100); // miss, retained
+    loadWidget(retaining, "texture_1", 100); // hit, still alive
+    st = retaining.stats();
+    cout << "Retention tier: strongHits=" << st.strongHits << " misses=" << st.misses
+         << " retained=" << st.retained << "\n";
+    
+    // Concurrent mode: keys are spread over lock-striped shards, and
+    // simultaneous misses on one key share a single build
+    cout << "Concurrent cache (" << smartptrs::ResourceCache<Widget,
+            smartptrs::Concurrent<8>>::shardCount() << " shards), 4 threads:\n";
+    smartptrs::ResourceCache<Widget, smartptrs::Concurrent<8>> shared;
+    vector<shared_ptr<Widget>> results(4);
+    vector<thread> workers;
+    for (size_t i = 0; i < results.size(); ++i) {
+        workers.emplace_back([&shared, &results, i] {
+            results[i] = shared.getOrCreate("texture_2", [] {
+                this_thread::sleep_for(chrono::milliseconds(20)); // slow load
+                return make_shared<Widget>(101, "texture_2");
+            });
+        });
+    }
+    for (auto& t : workers) t.join();
+    cout << "All threads got the same Widget: "
+         << (count(results.begin(), results.end(), results[0]) == 4) << "\n";
+
+    // getOrCreateAsync: the slow load runs on a pool and the caller gets a
+    // load_task at once - co_await it in C++20, get() it like a future in
+    // C++17. Requests for one key share the load; a cancelled one holds nothing
+    smartptrs::thread_pool loaders(2);
+    auto slowLoad = [] {
+        this_thread::sleep_for(chrono::milliseconds(20));
+        return make_shared<Widget>(102, "texture_3");
+    };
+    smartptrs::load_task<Widget> first = shared.getOrCreateAsync("texture_3", loaders, slowLoad);
+    smartptrs::load_task<Widget> second = shared.getOrCreateAsync("texture_3", loaders, slowLoad);
+    smartptrs::load_task<Widget> abandoned = shared.getOrCreateAsync("texture_3", loaders, slowLoad);
+    abandoned.cancel();
+    auto texture = first.get();
+    cout << "Async load shared by both requesters: " << (texture == second.get()) << "\n";
+
+    // Warm start: save the live entries, then a fresh cache (the next run)
+    // maps the file and decodes texture_2 on first use instead of calling
+    // the slow factory
+    size_t saved = smartptrs::save_snapshot(shared, "cache.snap",
+        [](const Widget& w, string& out) { out += to_string(w.id); });
+    smartptrs::ResourceCache<Widget> warm;
+    auto snap = smartptrs::warm_start(warm, "cache.snap", [](string_view key, string_view bytes) {
+        return make_shared<Widget>(stoi(string(bytes)), string(key));
+    });
+    auto restored = warm.getOrCreate("texture_2", [] { return make_shared<Widget>(0, "never built"); });
+    cout << "Snapshot of " << saved << " entries; texture_2 restored as Widget(" << restored->id
+         << "), decoded from snapshot: " << warm.stats().sourced << "\n";
+    remove("cache.snap");
 }
 
 // 7. Observer Pattern with weak_ptr (prevents memory leaks)
@@ -361,6 +517,26 @@ void observerPatternExample() {
     obs1.reset(); // observer1 destroyed
     cout << "obs1 destroyed, notifying again:\n";
     subject.notify(); // only obs2 notified
+    
+    // For many notifying threads: smartptrs::ConcurrentSubject (subject.hpp)
+    // reads an immutable snapshot without locks and compacts expired
+    // entries in batches rather than on every notify
+    smartptrs::ConcurrentSubject<Widget> concurrent;
+    auto obs3 = make_shared<Widget>(602, "observer3");
+    auto obs4 = make_shared<Widget>(603, "observer4");
+    concurrent.attach(obs3);
+    concurrent.attach(obs4);
+    obs3.reset();
+    size_t notified = concurrent.notify([](const Widget& w) { w.greet(); });
+    cout << "ConcurrentSubject notified " << notified
+         << ", entries after compaction: " << concurrent.size() << '\n';
+    
+    // Large lists can be split into chunks on a work-stealing pool;
+    // notifyAsync returns a handle instead of blocking
+    smartptrs::thread_pool pool(2);
+    smartptrs::notify_handle pending = concurrent.notifyAsync(pool, [](const Widget& w) { w.greet(); });
+    notified = pending.wait();
+    cout << "Async notify completed: " << notified << " observer(s)\n";
 }
 
 // 8. RAII with custom deleters (e.g., FILE*)
@@ -382,6 +558,28 @@ void raiiExample() {
         cout << "File written, will auto-close on scope exit\n";
     }
     // file closes automatically via FileCloser
+
+    // Same deleter, but fclose runs on a background drain thread, so the
+    // thread that drops the handle doesn't wait for the close
+    unique_ptr<FILE, smartptrs::deferred_deleter<FileCloser>> deferred(fopen("test.txt", "a"));
+    static_assert(sizeof(deferred) == sizeof(FILE*), "stateless deleter adds no size");
+    deferred.reset();
+    smartptrs::reclamation_queue::global().flush(); // wait for the close
+    auto stats = smartptrs::reclamation_queue::global().stats();
+    cout << "Deferred close drained: " << stats.drained << ", queue depth " << stats.depth << "\n";
+
+    // Close function fixed at compile time: one word, no functor to write
+    smartptrs::unique_file log(fopen("test.txt", "a"));
+    cout << "unique_file is " << sizeof(log) << " bytes, open: " << (log ? "yes" : "no") << "\n";
+
+    // High-volume logging: format into an owned buffer, one write() per
+    // 64 KiB instead of a locked fprintf per line
+    fflush(file.get()); // so the appends land after the stdio buffer
+    {
+        smartptrs::buffered_writer events("test.txt", smartptrs::open_mode::append);
+        for (int i = 0; i < 3; ++i) events.print("event ", i, ": buffered\n");
+        cout << "buffered_writer holding " << events.buffered() << " bytes, written on scope exit\n";
+    }
 }
 
 // 9. Move semantics: unique_ptr in vector (move-only type)
@@ -399,11 +597,41 @@ void moveSemanticsExample() {
     // Move from vector
     auto moved = move(widgets[0]);
     cout << "Moved widgets[0] out. Is null? " << (widgets[0] == nullptr) << '\n';
+
+    // Many shared objects at once: make_shared_batch (batch_make.hpp) carves
+    // all control blocks + Widgets from one slab, still owned one by one
+    vector<shared_ptr<Widget>> batch = smartptrs::make_shared_batch<Widget>(3, 710, "batch");
+    batch[1]->id = 711;
+    batch[2]->id = 712;
+    batch.erase(batch.begin()); // Widget 710 destroyed now; slab freed with the last one
+    cout << "make_shared_batch: " << batch.size() << " left, use_count " << batch[0].use_count() << '\n';
+
+    // Under heavy churn, recycle instead: the deleter returns the Widget to
+    // a per-thread free list and acquire() hands the same object back
+    using WidgetPool = smartptrs::ObjectPool<Widget>;
+    WidgetPool::handle pooled = WidgetPool::acquire(702, "pooled");
+    const Widget* first = pooled.get();
+    pooled.reset(); // not freed
+    pooled = WidgetPool::acquire(703, "pooled"); // hit: same storage, rebuilt as Widget(703)
+    cout << "Recycled same Widget: " << (pooled.get() == first) << ", now id " << pooled->id << '\n';
+    const smartptrs::pool_stats stats = WidgetPool::stats();
+    cout << "Pool hit rate " << stats.hitRate() << ", peak size " << stats.peakSize << '\n';
+
+    // For scans over many Widgets, store them contiguously and hold
+    // generational handles, which expire like weak_ptr when erased
+    smartptrs::slot_map<Widget> slots;
+    slots.reserve(4); // Widget has no move constructor: avoid regrowth copies
+    auto a = slots.insert(704, "slot");
+    auto b = slots.insert(705, "slot");
+    slots.erase(b);
+    auto c = slots.insert(706, "slot"); // reuses b's slot with a new generation
+    cout << "Handle b expired: " << slots.expired(b) << ", get(b) null: " << (slots.get(b) == nullptr)
+         << ", a and c live: " << (slots.get(a) && slots.get(c)) << '\n';
 }
 
 // 10. Polymorphic deleters with unique_ptr
-struct Base { virtual ~Base() { cout << "~Base()\n"; } };
-struct Derived : Base { ~Derived() override { cout << "~Derived()\n"; } };
+using Base = smartptrs::BasicBase<DemoTrace>;
+using Derived = smartptrs::BasicDerived<DemoTrace>;
 
 void polymorphicDeletionExample() {
     cout << "\n--- Polymorphic Deletion ---\n";
@@ -411,6 +639,13 @@ void polymorphicDeletionExample() {
     unique_ptr<Base> ptr = make_unique<Derived>();
     cout << "unique_ptr<Base> holding Derived will call ~Derived then ~Base\n";
     // Automatic cleanup calls Derived destructor first
+
+    // poly_value (poly_value.hpp): same virtual-destructor cleanup, but a
+    // small Derived lives in the value's own buffer - no heap allocation
+    smartptrs::poly_value<Base, 16> value(in_place_type<Derived>);
+    smartptrs::poly_value<Base, 16> moved = move(value);
+    cout << "poly_value<Base> holding Derived inline: " << moved.inlined()
+         << ", moved-from empty: " << !value << '\n';
 }
 
 //=============================================================================
@@ -441,6 +676,104 @@ void threadSafetyExample() {
     cout << "Threads finished. Final use_count: " << shared.use_count() << '\n';
     cout << "NOTE: While ref-counting is thread-safe, the pointed-to object is NOT!\n";
     cout << "You still need mutex/locks to protect the Widget's data members.\n";
+
+    // t1 and t2 each copied the shared_ptr: an atomic increment and decrement
+    // on the shared control block. The thread is joined while `shared` is
+    // alive, so borrowing (borrowed_ptr.hpp) is enough and the count is untouched
+    thread borrower([w = smartptrs::borrowed_ptr<const Widget>(shared)] { w->greet(); });
+    borrower.join();
+    cout << "borrowed_ptr capture: use_count stayed " << shared.use_count() << '\n';
+
+    // When copies that must own stay mostly on the creating thread, biased_ptr
+    // (biased_ptr.hpp) counts them with plain increments there; other threads
+    // use a separate atomic count, merged back into the owner's
+    auto biased = smartptrs::make_biased<Widget>(840, "biased");
+    thread t5([copy = biased] { cout << "Thread 5: non-atomic count here? " << copy.biased() << '\n'; });
+    t5.join();
+    cout << "biased_ptr on its creating thread: non-atomic count? " << biased.biased() << '\n';
+
+    // One thread writes the Widget while another copies the pointer: with
+    // make_shared the counts and Widget::id share a cache line (false sharing).
+    // make_shared_padded (padded_shared.hpp) gives the counts their own line
+    auto hot = smartptrs::make_shared_padded<Widget>(850, "padded");
+    thread writer([&hot] { hot->id = 851; });
+    auto hotCopy = hot;
+    writer.join();
+    const bool ownLine = reinterpret_cast<uintptr_t>(hot.get()) % smartptrs::kCacheLineSize == 0;
+    cout << "make_shared_padded: Widget starts its own cache line? " << ownLine << '\n';
+    
+    // cout serializes the threads above. buffered_trace logs into a buffer
+    // owned by each thread instead and prints after the threads are done.
+    using BufferedWidget = smartptrs::BasicWidget<smartptrs::buffered_trace>;
+    thread t3([] { make_shared<BufferedWidget>(810, "buffered")->greet(); });
+    thread t4([] { make_shared<BufferedWidget>(820, "buffered")->greet(); });
+    t3.join();
+    t4.join();
+    cout << "Buffered lifecycle log from threads 3 and 4:\n";
+    smartptrs::buffered_trace::flush(cout);
+    
+    // Many readers, one writer replacing the whole object: publish it through
+    // an atomic_shared_slot (atomic_slot.hpp). Readers pin instead of locking,
+    // so the old version is destroyed once the last reader has moved on.
+    smartptrs::atomic_shared_slot<Widget> config(make_shared<Widget>(830, "config-v1"));
+    thread reader([&config] { config.read([](const shared_ptr<Widget>& w) { w->greet(); }); });
+    reader.join();
+    config.store(make_shared<Widget>(831, "config-v2"));
+    smartptrs::epoch_reclaimer::synchronize(); // wait out readers of v1
+    config.load()->greet();
+}
+
+// Intrusive ref-counting (intrusive_ptr.hpp): the count lives inside the
+// object, so the pointer is one word and has no separate control block
+struct CountedWidget : Widget,
+                       smartptrs::ref_counted<CountedWidget, smartptrs::thread_safe_count, true> {
+    using Widget::Widget;
+};
+
+void intrusivePtrExample() {
+    cout << "\n--- intrusive_ptr: Count Inside the Object ---\n";
+    auto ip = smartptrs::make_intrusive<CountedWidget>(900, "intrusive");
+    auto ip2 = ip; // copies one word, bumps the count stored in *ip
+    cout << "sizeof(intrusive_ptr) = " << sizeof(ip)
+         << ", sizeof(shared_ptr) = " << sizeof(shared_ptr<Widget>)
+         << ", use_count: " << ip.use_count() << '\n';
+    
+    // Weak references are opt-in; the first one allocates a small side table
+    smartptrs::weak_intrusive_ptr<CountedWidget> observer(ip);
+    if (auto locked = observer.lock()) locked->greet();
+    ip.reset();
+    ip2.reset();
+    cout << "weak_intrusive_ptr expired: " << observer.expired() << '\n';
+}
+
+// Non-atomic shared ownership (local_shared_ptr.hpp) for objects that never
+// leave their thread - debug builds assert every access is on that thread
+void localSharedPtrExample() {
+    cout << "\n--- local_shared_ptr: Single-Thread Shared Ownership ---\n";
+    auto local = smartptrs::make_local_shared<Widget>(950, "event-loop");
+    {
+        auto copy = local; // plain increment, no locked RMW
+        cout << "use_count: " << local.use_count() << '\n';
+        copy->greet();
+    }
+    cout << "use_count after copy scope: " << local.use_count() << '\n';
+}
+
+// Deferred reclamation (hazard.hpp): readers of a swappable handle protect it
+// with a hazard pointer instead of a ref count; the writer retires the old
+// handle with the same FileCloser a unique_ptr would use
+void reclamationExample() {
+    cout << "\n--- Hazard Pointers: retire(ptr, deleter) ---\n";
+    atomic<FILE*> log{fopen("test.txt", "a")};
+    {
+        smartptrs::hazard_reclaimer::guard hp;
+        if (FILE* fp = hp.protect(log)) {
+            fprintf(fp, "Written under a hazard pointer\n");
+            cout << "Reader appended through a protected FILE*\n";
+        }
+    }
+    smartptrs::hazard_reclaimer::retire(log.exchange(nullptr), FileCloser());
+    smartptrs::hazard_reclaimer::collect(); // no reader protects it: closes now
 }
 
 //=============================================================================
@@ -468,7 +801,9 @@ void bestPracticesAndPitfalls() {
     cout << "  4. Pass smart pointers efficiently:\n";
     cout << "     - By value: transfer ownership\n";
     cout << "     - By const&: observe without copy\n";
-    cout << "     - By raw pointer/reference: just use, don't manage\n\n";
+    cout << "     - By raw pointer/reference: just use, don't manage\n";
+    cout << "     - By borrowed_ptr<T>: like const&, but from any owner type\n";
+    cout << "       and safe to capture in joined tasks (debug-checked)\n\n";
     
     cout << "COMMON PITFALLS:\n";
     cout << "  - Don't create multiple shared_ptr from same raw pointer\n";
@@ -489,8 +824,21 @@ void bestPracticesAndPitfalls() {
     cout << "  - make_shared is faster (1 allocation vs 2)\n";
     cout << "  - unique_ptr has zero overhead (when not using custom deleter)\n";
     cout << "  - shared_ptr has atomic ref-count overhead\n";
+    cout << "  - intrusive_ptr keeps the count in the object (1 word, no control block)\n";
+    cout << "  - local_shared_ptr skips atomics for objects that stay on one thread\n";
+    cout << "  - biased_ptr skips them on the creating thread, and still crosses threads\n";
     cout << "  - Pass by const& to avoid ref-count changes\n";
+    cout << "  - Capture borrowed_ptr, not shared_ptr copies, in tasks that are joined\n";
     cout << "  - Reserve vector<unique_ptr> capacity to avoid moves\n";
+    cout << "  - Use make_shared_padded for objects written while others copy the pointer\n";
+    cout << "  - Recycle high-churn objects through ObjectPool instead of new/delete\n";
+    cout << "  - Call gc_heap::collect(budget) per tick to bound gc_ptr cycle pauses\n";
+    cout << "  - Dispatch type names through factory_registry, not string-compare chains\n";
+    cout << "  - Start slow resource loads with getOrCreateAsync instead of blocking\n";
+    cout << "  - Warm-start caches from a save_snapshot file instead of rebuilding\n";
+    cout << "  - Store small polymorphic objects in poly_value to skip the heap\n";
+    cout << "  - Create many shared objects with make_shared_batch (1 allocation)\n";
+    cout << "  - Numbers for each tip: bench/pointer_ops_bench.cpp\n";
 }
 
 int main() {
@@ -501,6 +849,7 @@ int main() {
     sharedPtrExample();
     weakPtrExample();
     cycleDemo();
+    arenaExample();
     advancedFeatures();
     resourceCacheExample();
     observerPatternExample();
@@ -508,6 +857,9 @@ int main() {
     moveSemanticsExample();
     polymorphicDeletionExample();
     threadSafetyExample();
+    intrusivePtrExample();
+    localSharedPtrExample();
+    reclamationExample();
     bestPracticesAndPitfalls();
 
     cout << "\n=== All examples complete ===\n";
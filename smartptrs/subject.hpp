@@ -0,0 +1,289 @@
+/*******************************************************************************
+ * subject.hpp
+ * Observer list for many notifying threads: copy-on-write snapshots read
+ * without locks, expired entries compacted in batches
+ *
+ * The tutorial's Subject locks every weak_ptr and rebuilds its vector with
+ * remove_if on each notify(), and attach() can't run alongside notify().
+ * ConcurrentSubject<T> instead publishes an immutable snapshot of weak_ptrs:
+ *
+ *   - notify(fn) pins an epoch (epoch.hpp), reads the current snapshot and
+ *     calls fn(T&) for each live observer. No lock, no shared writes beyond
+ *     the weak_ptr::lock() each live observer requires.
+ *   - attach() appends in place while the snapshot has spare capacity: the
+ *     entry is written past the published count, then the count is
+ *     released, so readers never see a partial entry. A full snapshot is
+ *     copied into one twice the live size.
+ *   - detach(), and compaction, build a new snapshot without the dead
+ *     entries and retire the old one. notify() only triggers compaction
+ *     once at least a quarter of the entries it walked had expired
+ *     (and never blocks on a writer to do it).
+ *
+ * DISPATCH MODES:
+ *   - notify(fn)                        caller's thread, in order
+ *   - notifyParallel(pool, fn, chunk)   snapshot split into chunks of
+ *                                       kChunk observers (sized to stay in
+ *                                       L1 while walked), run on a
+ *                                       work-stealing thread_pool; the
+ *                                       caller helps and returns when done
+ *   - notifyAsync(pool, fn, chunk)      same, returning a notify_handle at
+ *                                       once; wait() joins and rethrows
+ *
+ * Writers (attach/detach/compaction) serialize on a mutex; readers never
+ * take it. fn runs outside every internal lock and may attach or detach.
+ ******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "epoch.hpp"
+#include "thread_pool.hpp"
+
+namespace smartptrs {
+
+namespace detail {
+
+struct notify_state {
+    explicit notify_state(thread_pool& p) : pool(p) {}
+    virtual ~notify_state() = default;
+
+    thread_pool& pool;
+    task_latch latch{0};
+    std::atomic<std::size_t> notified{0};
+};
+
+} // namespace detail
+
+// Completion handle for ConcurrentSubject::notifyAsync
+class notify_handle {
+public:
+    notify_handle() = default;
+    explicit notify_handle(std::shared_ptr<detail::notify_state> state) : state_(std::move(state)) {}
+
+    bool valid() const noexcept { return state_ != nullptr; }
+    bool done() const noexcept { return !state_ || state_->latch.done(); }
+
+    // Helps the pool until the notification finished; rethrows the first
+    // exception fn threw and returns how many observers were notified
+    std::size_t wait() {
+        if (!state_) return 0;
+        state_->latch.wait(state_->pool);
+        return state_->notified.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<detail::notify_state> state_;
+};
+
+template<typename T>
+class ConcurrentSubject {
+public:
+    static constexpr std::size_t kInitialCapacity = 16;
+    // Observers per parallel task: 1024 weak_ptrs are 16 KiB, so one
+    // chunk's slots sit comfortably in a core's L1 while it is walked
+    static constexpr std::size_t kChunk = 1024;
+
+    ConcurrentSubject() : current_(new Snapshot(kInitialCapacity)) {}
+    ConcurrentSubject(const ConcurrentSubject&) = delete;
+    ConcurrentSubject& operator=(const ConcurrentSubject&) = delete;
+
+    // No notify() may still be running; older snapshots are already retired
+    ~ConcurrentSubject() { delete current_.load(std::memory_order_relaxed); }
+
+    void attach(const std::shared_ptr<T>& observer) {
+        std::lock_guard<std::mutex> lock(writer_);
+        Snapshot* s = current_.load(std::memory_order_relaxed);
+        if (s->count.load(std::memory_order_relaxed) == s->capacity) s = rebuild(s, {}, 1);
+        const std::size_t n = s->count.load(std::memory_order_relaxed);
+        s->slots[n] = observer; // invisible to readers until count moves
+        s->count.store(n + 1, std::memory_order_release);
+    }
+
+    // Removes every entry for `observer`; true if there was one
+    bool detach(const std::shared_ptr<T>& observer) {
+        std::lock_guard<std::mutex> lock(writer_);
+        Snapshot* s = current_.load(std::memory_order_relaxed);
+        const std::size_t n = s->count.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < n; ++i) {
+            if (sameOwner(s->slots[i], observer)) {
+                rebuild(s, observer, 0);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls fn(T&) for each live observer; returns how many were notified
+    template<typename Fn>
+    std::size_t notify(Fn&& fn) {
+        std::size_t notified = 0;
+        std::size_t dead = 0;
+        Snapshot* s;
+        {
+            epoch_reclaimer::guard pin;
+            s = current_.load(std::memory_order_acquire);
+            const std::size_t n = s->count.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < n; ++i) {
+                if (std::shared_ptr<T> observer = s->slots[i].lock()) {
+                    fn(*observer);
+                    ++notified;
+                } else {
+                    ++dead;
+                }
+            }
+        }
+        if (dead != 0 && dead * 4 >= notified + dead) compactIfCurrent(s);
+        return notified;
+    }
+
+    // Splits the snapshot into chunks of `chunk` observers and runs them on
+    // `pool`; the calling thread helps until every chunk is done. fn is
+    // called concurrently from several threads. A list that fits in one
+    // chunk is notified inline - there'd be nothing to run in parallel.
+    template<typename Fn>
+    std::size_t notifyParallel(thread_pool& pool, Fn&& fn, std::size_t chunk = kChunk) {
+        if (size() <= (chunk ? chunk : kChunk)) return notify(fn);
+        return notifyAsync(pool, std::ref(fn), chunk).wait();
+    }
+
+    // Same, but returns at once; fn is copied into the operation. The
+    // snapshot stays pinned until the last chunk finishes, and the subject
+    // must outlive the operation.
+    template<typename Fn>
+    notify_handle notifyAsync(thread_pool& pool, Fn fn, std::size_t chunk = kChunk) {
+        if (chunk == 0) chunk = kChunk;
+        auto op = std::make_shared<AsyncNotify<Fn>>(pool, std::move(fn), *this);
+        const std::size_t n = op->snapshot->count.load(std::memory_order_acquire);
+        const std::size_t chunks = (n + chunk - 1) / chunk;
+        op->latch.reset(chunks);
+        op->chunksLeft.store(chunks, std::memory_order_relaxed);
+        if (chunks == 0) op->pin.release();
+        for (std::size_t begin = 0; begin < n; begin += chunk) {
+            const std::size_t end = begin + chunk < n ? begin + chunk : n;
+            pool.submit([op, begin, end] { op->run(begin, end); });
+        }
+        return notify_handle(std::move(op));
+    }
+
+    // Drops expired entries now
+    void compact() {
+        std::lock_guard<std::mutex> lock(writer_);
+        rebuild(current_.load(std::memory_order_relaxed), {}, 0);
+    }
+
+    // Entries in the current snapshot, including expired ones not yet compacted
+    std::size_t size() const noexcept {
+        return current_.load(std::memory_order_acquire)->count.load(std::memory_order_acquire);
+    }
+
+    // Snapshots copied so far (growth, detach and compaction)
+    std::size_t rebuilds() const noexcept { return rebuilds_.load(std::memory_order_relaxed); }
+
+private:
+    struct Snapshot {
+        explicit Snapshot(std::size_t cap)
+            : capacity(cap), slots(std::make_unique<std::weak_ptr<T>[]>(cap)) {}
+
+        const std::size_t capacity;
+        std::atomic<std::size_t> count{0};
+        // [0, count) is immutable once published
+        std::unique_ptr<std::weak_ptr<T>[]> slots;
+    };
+
+    static bool sameOwner(const std::weak_ptr<T>& a, const std::weak_ptr<T>& b) noexcept {
+        return !a.owner_before(b) && !b.owner_before(a);
+    }
+
+    static std::size_t liveCount(const Snapshot* s) noexcept {
+        std::size_t live = 0;
+        const std::size_t n = s->count.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < n; ++i) live += !s->slots[i].expired();
+        return live;
+    }
+
+    // Publishes a copy of s without expired entries (and without `drop`),
+    // with room for `extra` more plus headroom. Caller holds writer_.
+    // Entries are copied as weak_ptrs, so no observer can die under the lock.
+    Snapshot* rebuild(Snapshot* s, const std::weak_ptr<T>& drop, std::size_t extra) {
+        const std::size_t live = liveCount(s);
+        std::size_t capacity = kInitialCapacity;
+        while (capacity < 2 * (live + extra)) capacity *= 2;
+
+        auto next = std::make_unique<Snapshot>(capacity);
+        std::size_t kept = 0;
+        const std::size_t n = s->count.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::weak_ptr<T>& entry = s->slots[i];
+            if (!entry.expired() && !sameOwner(entry, drop)) next->slots[kept++] = entry;
+        }
+        next->count.store(kept, std::memory_order_relaxed);
+
+        Snapshot* published = next.release();
+        current_.store(published, std::memory_order_release);
+        epoch_reclaimer::retire(s);
+        rebuilds_.fetch_add(1, std::memory_order_relaxed);
+        return published;
+    }
+
+    // One notifyAsync() call, shared by its chunk tasks and the handle
+    template<typename Fn>
+    struct AsyncNotify final : detail::notify_state {
+        AsyncNotify(thread_pool& p, Fn f, ConcurrentSubject& owner)
+            : detail::notify_state(p), fn(std::move(f)), subject(owner),
+              snapshot(subject.current_.load(std::memory_order_acquire)) {}
+
+        void run(std::size_t begin, std::size_t end) noexcept {
+            std::size_t live = 0;
+            std::size_t expired = 0;
+            std::exception_ptr error;
+            try {
+                for (std::size_t i = begin; i < end; ++i) {
+                    if (std::shared_ptr<T> observer = snapshot->slots[i].lock()) {
+                        fn(*observer);
+                        ++live;
+                    } else {
+                        ++expired;
+                    }
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            notified.fetch_add(live, std::memory_order_relaxed);
+            dead.fetch_add(expired, std::memory_order_relaxed);
+            if (chunksLeft.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                const std::size_t d = dead.load(std::memory_order_relaxed);
+                if (d != 0 && d * 4 >= d + notified.load(std::memory_order_relaxed)) {
+                    subject.compactIfCurrent(snapshot);
+                }
+                pin.release();
+            }
+            latch.countDown(std::move(error));
+        }
+
+        Fn fn;
+        ConcurrentSubject& subject;
+        epoch_reclaimer::ticket pin; // before snapshot: pinned, then loaded
+        Snapshot* snapshot;
+        std::atomic<std::size_t> chunksLeft{0};
+        std::atomic<std::size_t> dead{0};
+    };
+
+    // Called by notify(): skips the work if a writer is busy or has already
+    // replaced the snapshot that was walked
+    void compactIfCurrent(Snapshot* walked) {
+        std::unique_lock<std::mutex> lock(writer_, std::try_to_lock);
+        if (lock && current_.load(std::memory_order_relaxed) == walked) rebuild(walked, {}, 0);
+    }
+
+    std::atomic<Snapshot*> current_;
+    std::mutex writer_;
+    std::atomic<std::size_t> rebuilds_{0};
+};
+
+} // namespace smartptrs
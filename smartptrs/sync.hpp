@@ -0,0 +1,40 @@
+/*******************************************************************************
+ * sync.hpp
+ * Tiny lockables shared by the smartptrs headers
+ *
+ * - null_mutex: satisfies Lockable but does nothing (single-threaded modes)
+ * - spin_lock:  one-byte test-and-test-and-set lock for critical sections
+ *               that are a handful of instructions long
+ ******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+namespace smartptrs {
+
+// Lockable that does nothing - used when there is nothing to protect
+struct null_mutex {
+    void lock() noexcept {}
+    void unlock() noexcept {}
+    bool try_lock() noexcept { return true; }
+};
+
+class spin_lock {
+    std::atomic<bool> locked_{false};
+public:
+    void lock() noexcept {
+        for (;;) {
+            if (!locked_.exchange(true, std::memory_order_acquire)) return;
+            // Spin on a plain load so waiters don't bounce the cache line
+            while (locked_.load(std::memory_order_relaxed)) std::this_thread::yield();
+        }
+    }
+    bool try_lock() noexcept {
+        return !locked_.load(std::memory_order_relaxed) &&
+               !locked_.exchange(true, std::memory_order_acquire);
+    }
+    void unlock() noexcept { locked_.store(false, std::memory_order_release); }
+};
+
+} // namespace smartptrs
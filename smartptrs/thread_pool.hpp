@@ -0,0 +1,206 @@
+/*******************************************************************************
+ * thread_pool.hpp
+ * Small work-stealing thread pool and a latch for fork/join work
+ *
+ * Each worker owns a deque: it pushes and pops its own tasks at the back
+ * (newest first, still warm in cache) and, when empty, steals the oldest
+ * task from the front of another worker's deque. Tasks submitted from
+ * outside the pool are spread round-robin. Idle workers sleep on a
+ * condition variable and are only woken when someone is actually asleep.
+ *
+ * task_latch counts outstanding tasks. wait(pool) runs queued tasks on the
+ * calling thread until the count reaches zero, so waiting from inside a
+ * pool task can't deadlock the pool, and rethrows the first exception a
+ * task reported.
+ *
+ *   smartptrs::thread_pool pool;            // hardware_concurrency() workers
+ *   smartptrs::task_latch latch(chunks);
+ *   for (...) pool.submit([&] { work(); latch.countDown(); });
+ *   latch.wait(pool);
+ *
+ * Tasks must not throw out of the pool (std::terminate); catch and pass the
+ * exception to task_latch::countDown instead. The destructor finishes every
+ * queued task before joining.
+ ******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sync.hpp"
+
+namespace smartptrs {
+
+class thread_pool {
+public:
+    using task = std::function<void()>;
+
+    explicit thread_pool(std::size_t threads = defaultThreads()) : queues_(threads ? threads : 1) {
+        workers_.reserve(queues_.size());
+        for (std::size_t i = 0; i < queues_.size(); ++i) {
+            workers_.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            stopping_.store(true);
+        }
+        wake_.notify_all();
+        for (std::thread& w : workers_) w.join();
+    }
+
+    static std::size_t defaultThreads() noexcept {
+        const unsigned n = std::thread::hardware_concurrency();
+        return n ? n : 1;
+    }
+
+    std::size_t size() const noexcept { return workers_.size(); }
+
+    // From a worker of this pool the task goes to that worker's own deque
+    void submit(task t) {
+        const Worker& self = currentWorker();
+        const std::size_t target = self.pool == this
+            ? self.index
+            : next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        // Counted before it's visible, so pending_ never drops below zero
+        pending_.fetch_add(1, std::memory_order_seq_cst);
+        {
+            Queue& q = queues_[target];
+            std::lock_guard<spin_lock> lock(q.lock);
+            q.tasks.push_back(std::move(t));
+        }
+        if (sleepers_.load(std::memory_order_seq_cst) != 0) {
+            // Taking the mutex orders this with a worker about to sleep
+            { std::lock_guard<std::mutex> lock(sleepMutex_); }
+            wake_.notify_one();
+        }
+    }
+
+    // Runs one queued task on the calling thread; false if none was found
+    bool runPendingTask() {
+        const Worker& self = currentWorker();
+        task t;
+        if (!take(self.pool == this ? self.index : 0, t)) return false;
+        t();
+        return true;
+    }
+
+private:
+    struct alignas(64) Queue {
+        spin_lock lock;
+        std::deque<task> tasks;
+    };
+
+    struct Worker {
+        const thread_pool* pool = nullptr;
+        std::size_t index = 0;
+    };
+
+    static Worker& currentWorker() noexcept {
+        static thread_local Worker worker;
+        return worker;
+    }
+
+    // Own deque from the back, then the others from the front
+    bool take(std::size_t home, task& out) {
+        if (pending_.load(std::memory_order_relaxed) == 0) return false;
+        for (std::size_t k = 0; k < queues_.size(); ++k) {
+            const std::size_t i = (home + k) % queues_.size();
+            Queue& q = queues_[i];
+            std::lock_guard<spin_lock> lock(q.lock);
+            if (q.tasks.empty()) continue;
+            if (k == 0) {
+                out = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            } else {
+                out = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(std::size_t index) {
+        currentWorker() = Worker{this, index};
+        task t;
+        for (;;) {
+            if (take(index, t)) {
+                t();
+                t = nullptr; // release captures before sleeping
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            wake_.wait(lock, [this] {
+                return pending_.load(std::memory_order_seq_cst) != 0 || stopping_.load();
+            });
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            if (stopping_.load() && pending_.load() == 0) return;
+        }
+    }
+
+    std::vector<Queue> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> next_{0};
+    std::atomic<std::size_t> pending_{0}; // submitted, not yet taken
+    std::atomic<std::size_t> sleepers_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+};
+
+class task_latch {
+public:
+    explicit task_latch(std::size_t count) noexcept : remaining_(count) {}
+    task_latch(const task_latch&) = delete;
+    task_latch& operator=(const task_latch&) = delete;
+
+    // One task finished; pass its exception, if any
+    // (Under the mutex: wait() takes it before returning, so the latch
+    // can't be destroyed while the last countDown is still inside it.)
+    void countDown(std::exception_ptr error = nullptr) noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error && !error_) error_ = std::move(error);
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) done_.notify_all();
+    }
+
+    // Re-arms the latch; nothing may be counting down or waiting
+    void reset(std::size_t count) noexcept { remaining_.store(count, std::memory_order_relaxed); }
+
+    bool done() const noexcept { return remaining_.load(std::memory_order_acquire) == 0; }
+
+    // Helps `pool` with queued work until every task has counted down
+    void wait(thread_pool& pool) {
+        while (!done()) {
+            if (pool.runPendingTask()) continue;
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this] { return done(); });
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error_) std::rethrow_exception(error_);
+    }
+
+private:
+    std::atomic<std::size_t> remaining_;
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::exception_ptr error_;
+};
+
+} // namespace smartptrs
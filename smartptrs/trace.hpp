@@ -0,0 +1,153 @@
+/*******************************************************************************
+ * trace.hpp
+ * Compile-time trace policies for object lifecycle logging
+ *
+ * Types that log their construction and destruction take the policy as a
+ * template parameter and guard every call with if constexpr:
+ *
+ *   if constexpr (Trace::enabled) Trace::log("Widget(", id, ") constructed");
+ *
+ * POLICIES:
+ *   - no_trace        enabled = false: the call and its arguments compile
+ *                     away, so the type is as cheap as an untraced one
+ *   - stream_trace    formats the line and writes it to std::cout at once
+ *                     (one write per line, so threads don't interleave
+ *                     characters)
+ *   - buffered_trace  appends to a buffer owned by the calling thread - no
+ *                     locks, no I/O. flush(os) prints the calling thread's
+ *                     buffer plus the buffers of threads that have exited.
+ *
+ * log() accepts characters, integers, bools (as true/false) and anything
+ * convertible to std::string_view. A buffered line logged by a thread that
+ * is still running is only printed by that thread's own flush().
+ ******************************************************************************/
+#pragma once
+
+#include <charconv>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace smartptrs {
+
+namespace detail {
+
+template<typename T>
+void traceAppend(std::string& out, const T& value) {
+    if constexpr (std::is_same_v<T, char>) {
+        out.push_back(value);
+    } else if constexpr (std::is_same_v<T, bool>) {
+        out.append(value ? "true" : "false");
+    } else if constexpr (std::is_integral_v<T>) {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof digits, value);
+        out.append(digits, result.ptr);
+    } else {
+        out.append(std::string_view(value));
+    }
+}
+
+template<typename... Args>
+void traceLine(std::string& out, const Args&... args) {
+    (traceAppend(out, args), ...);
+    out.push_back('\n');
+}
+
+} // namespace detail
+
+struct no_trace {
+    static constexpr bool enabled = false;
+    template<typename... Args>
+    static void log(const Args&...) noexcept {}
+};
+
+struct stream_trace {
+    static constexpr bool enabled = true;
+    template<typename... Args>
+    static void log(const Args&... args) {
+        std::string line;
+        detail::traceLine(line, args...);
+        std::cout.write(line.data(), std::streamsize(line.size()));
+    }
+};
+
+class buffered_trace {
+public:
+    static constexpr bool enabled = true;
+
+    template<typename... Args>
+    static void log(const Args&... args) {
+        if (retired()) {
+            // This thread's buffer is already destroyed (thread_local
+            // destructor order): hand the line straight to the exited list
+            std::string line;
+            detail::traceLine(line, args...);
+            exited().add(std::move(line));
+            return;
+        }
+        detail::traceLine(threadBuffer().text, args...);
+    }
+
+    // Prints exited threads' buffers (in exit order), then this thread's
+    static void flush(std::ostream& os) {
+        for (const std::string& text : exited().drain()) os << text;
+        if (!retired()) {
+            std::string& mine = threadBuffer().text;
+            os << mine;
+            mine.clear();
+        }
+        os.flush();
+    }
+
+    // Drops everything flush() would have printed
+    static void discard() {
+        exited().drain();
+        if (!retired()) threadBuffer().text.clear();
+    }
+
+private:
+    struct Exited {
+        std::mutex mutex;
+        std::vector<std::string> buffers;
+
+        void add(std::string text) {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.push_back(std::move(text));
+        }
+        std::vector<std::string> drain() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return std::exchange(buffers, {});
+        }
+    };
+
+    struct ThreadBuffer {
+        std::string text;
+        // Thread exit: the buffer outlives its thread until flushed
+        ~ThreadBuffer() {
+            if (!text.empty()) exited().add(std::move(text));
+            retired() = true;
+        }
+    };
+
+    static Exited& exited() {
+        // Never destroyed: threads may exit during static destruction
+        static Exited* e = new Exited;
+        return *e;
+    }
+
+    static ThreadBuffer& threadBuffer() {
+        static thread_local ThreadBuffer buffer;
+        return buffer;
+    }
+
+    static bool& retired() noexcept {
+        static thread_local bool flag = false; // trivially destructible
+        return flag;
+    }
+};
+
+} // namespace smartptrs
@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * unique_resource.hpp
+ * One-word RAII handles for C resources, with the close call fixed at
+ * compile time
+ *
+ * unique_ptr<FILE, FileCloser> needs a hand-written functor per resource, a
+ * capturing lambda or function-pointer deleter silently doubles its size,
+ * and it only holds pointers. unique_resource takes the close function as a
+ * template argument instead (C++17 `auto` non-type parameter), so the
+ * object is exactly one Handle and the close call inlines like a functor:
+ *
+ *   smartptrs::unique_file log(std::fopen("app.log", "a"));
+ *   smartptrs::unique_fd fd(::open("data.bin", O_RDONLY));
+ *   using unique_sock = smartptrs::unique_resource<int, &closeSocket, -1>;
+ *
+ * RULES:
+ *   - CloseFn is called as CloseFn(handle) for every handle != Invalid; its
+ *     return value is ignored
+ *   - Handle must be usable as a non-type template argument (pointers,
+ *     integers, enums), which is what keeps Invalid free of storage
+ *   - Resources that need more than one word to close (an mmap region is
+ *     address + length) don't fit; give them a small struct and unique_ptr
+ ******************************************************************************/
+#pragma once
+
+#include <cstdio>
+#include <utility>
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+namespace smartptrs {
+
+template<typename Handle, auto CloseFn, Handle Invalid = Handle{}>
+class unique_resource {
+public:
+    using handle_type = Handle;
+    static constexpr Handle invalid = Invalid;
+
+    unique_resource() noexcept = default;
+    explicit unique_resource(Handle h) noexcept : handle_(h) {}
+
+    unique_resource(unique_resource&& other) noexcept : handle_(other.release()) {}
+    unique_resource& operator=(unique_resource&& other) noexcept {
+        reset(other.release());
+        return *this;
+    }
+    unique_resource(const unique_resource&) = delete;
+    unique_resource& operator=(const unique_resource&) = delete;
+
+    ~unique_resource() { reset(); }
+
+    Handle get() const noexcept { return handle_; }
+    explicit operator bool() const noexcept { return handle_ != Invalid; }
+
+    // Gives up ownership without closing
+    Handle release() noexcept { return std::exchange(handle_, Invalid); }
+
+    // Closes the current handle (if any) and takes h
+    void reset(Handle h = Invalid) noexcept {
+        const Handle old = std::exchange(handle_, h);
+        if (old != Invalid) static_cast<void>(CloseFn(old));
+    }
+
+    void swap(unique_resource& other) noexcept { std::swap(handle_, other.handle_); }
+
+private:
+    Handle handle_ = Invalid;
+};
+
+namespace detail {
+
+// Library functions may not have their address taken; wrap them
+inline int closeFile(std::FILE* f) noexcept { return std::fclose(f); }
+#if __has_include(<unistd.h>)
+inline int closeFd(int fd) noexcept { return ::close(fd); }
+#endif
+
+} // namespace detail
+
+using unique_file = unique_resource<std::FILE*, &detail::closeFile, nullptr>;
+static_assert(sizeof(unique_file) == sizeof(std::FILE*), "unique_file must stay one pointer");
+
+#if __has_include(<unistd.h>)
+using unique_fd = unique_resource<int, &detail::closeFd, -1>;
+static_assert(sizeof(unique_fd) == sizeof(int), "unique_fd must stay one int");
+#endif
+
+} // namespace smartptrs
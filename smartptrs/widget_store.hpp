@@ -0,0 +1,206 @@
+/*******************************************************************************
+ * widget_store.hpp
+ * Structure-of-arrays Widget storage with SIMD bulk queries
+ *
+ * A Widget is a 4-byte id next to a 32-byte std::string, so scanning ids
+ * over Widget objects pulls the names through the cache too. WidgetStore
+ * keeps ids, names and liveness bits in separate arrays:
+ *
+ *   auto store = smartptrs::WidgetStore::create(1024);
+ *   std::size_t i = store->add(7, "seven");
+ *   store->findId(7);                   // i
+ *   store->countLive();                 // 1
+ *   store->filterIdRange(0, 9, hits);   // appends indices with 0 <= id <= 9
+ *   std::shared_ptr<int> id = store->idPtr(i); // aliasing, like idPtr in
+ *                                              // advancedFeatures()
+ *
+ * DETAILS:
+ *   - capacity is fixed at create() (rounded up to 64), so the arrays never
+ *     move and aliasing pointers stay valid; add() throws std::length_error
+ *     when full
+ *   - aliasing pointers keep the whole store alive, not their entry: an
+ *     erased index may be reused by a later add() (check live(i))
+ *   - bulk queries compare 8 ids per step with AVX2, or 2x4 with NEON on
+ *     AArch64, and fall back to scalar code elsewhere
+ *     (simdBackend() says which was compiled in); build with -mavx2 or
+ *     -march=native to get the AVX2 path on x86
+ *   - not thread-safe: concurrent readers are fine, writers need a lock
+ ******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace smartptrs {
+
+class WidgetStore : public std::enable_shared_from_this<WidgetStore> {
+public:
+    static constexpr std::size_t npos = ~std::size_t(0);
+    static constexpr std::size_t kMaxCapacity = std::size_t(1) << 32;
+
+    static std::shared_ptr<WidgetStore> create(std::size_t capacity) {
+        return std::shared_ptr<WidgetStore>(new WidgetStore(capacity));
+    }
+
+    WidgetStore(const WidgetStore&) = delete;
+    WidgetStore& operator=(const WidgetStore&) = delete;
+
+    // Stores (id, name) in a free index and returns it
+    std::size_t add(int id, std::string name) {
+        std::size_t i;
+        if (!free_.empty()) {
+            i = free_.back();
+        } else if (end_ < capacity_) {
+            i = end_;
+        } else {
+            throw std::length_error("WidgetStore: full");
+        }
+        names_[i] = std::move(name);
+        if (i == end_) ++end_;
+        else free_.pop_back();
+        ids_[i] = id;
+        live_[i / 64] |= std::uint64_t(1) << (i % 64);
+        return i;
+    }
+
+    void erase(std::size_t i) {
+        if (!live(i)) return;
+        live_[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+        names_[i].clear();
+        free_.push_back(i);
+    }
+
+    bool live(std::size_t i) const noexcept {
+        return i < end_ && (live_[i / 64] >> (i % 64) & 1) != 0;
+    }
+
+    int id(std::size_t i) const noexcept { return ids_[i]; }
+    const std::string& name(std::size_t i) const noexcept { return names_[i]; }
+
+    // Aliasing pointers to one entry's fields; they share ownership of the store
+    std::shared_ptr<int> idPtr(std::size_t i) { return {shared_from_this(), &ids_[i]}; }
+    std::shared_ptr<std::string> namePtr(std::size_t i) { return {shared_from_this(), &names_[i]}; }
+
+    // First live index holding id, or npos
+    std::size_t findId(int id) const noexcept {
+        for (std::size_t base = 0; base < end_; base += 8) {
+            const unsigned hits = matchEqual(base, id) & liveByte(base);
+            if (hits) return base + std::size_t(__builtin_ctz(hits));
+        }
+        return npos;
+    }
+
+    std::size_t countLive() const noexcept {
+        std::size_t n = 0;
+        for (std::size_t w = 0; w < (end_ + 63) / 64; ++w) n += std::size_t(__builtin_popcountll(live_[w]));
+        return n;
+    }
+
+    // Appends the indices of live entries with lo <= id <= hi
+    void filterIdRange(int lo, int hi, std::vector<std::size_t>& out) const {
+        if (lo > hi) return;
+        for (std::size_t base = 0; base < end_; base += 8) {
+            unsigned hits = matchRange(base, lo, hi) & liveByte(base);
+            while (hits) {
+                out.push_back(base + std::size_t(__builtin_ctz(hits)));
+                hits &= hits - 1;
+            }
+        }
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    static const char* simdBackend() noexcept {
+#if defined(__AVX2__)
+        return "avx2";
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        return "neon";
+#else
+        return "scalar";
+#endif
+    }
+
+private:
+    explicit WidgetStore(std::size_t capacity)
+        : capacity_(roundCapacity(capacity)),
+          ids_(new int[capacity_]()),
+          names_(new std::string[capacity_]),
+          live_(new std::uint64_t[capacity_ / 64]()) {}
+
+    static std::size_t roundCapacity(std::size_t n) {
+        if (n > kMaxCapacity) throw std::length_error("WidgetStore: capacity too large");
+        return (n + 63) / 64 * 64;
+    }
+
+    // Liveness bits of entries [base, base + 8); base is a multiple of 8
+    unsigned liveByte(std::size_t base) const noexcept {
+        return unsigned(live_[base / 64] >> (base % 64)) & 0xFFu;
+    }
+
+    // Bit k set if ids_[base + k] == id
+    unsigned matchEqual(std::size_t base, int id) const noexcept {
+        const int* p = &ids_[base];
+#if defined(__AVX2__)
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i eq = _mm256_cmpeq_epi32(v, _mm256_set1_epi32(id));
+        return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        const int32x4_t key = vdupq_n_s32(id);
+        return laneBits(vceqq_s32(vld1q_s32(p), key)) | laneBits(vceqq_s32(vld1q_s32(p + 4), key)) << 4;
+#else
+        unsigned bits = 0;
+        for (unsigned k = 0; k < 8; ++k) bits |= unsigned(p[k] == id) << k;
+        return bits;
+#endif
+    }
+
+    // Bit k set if lo <= ids_[base + k] <= hi, tested as the single
+    // unsigned compare (id - lo) <= (hi - lo)
+    unsigned matchRange(std::size_t base, int lo, int hi) const noexcept {
+        const int* p = &ids_[base];
+        const auto span = std::uint32_t(hi) - std::uint32_t(lo);
+#if defined(__AVX2__)
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i d = _mm256_sub_epi32(v, _mm256_set1_epi32(lo));
+        const __m256i in = _mm256_cmpeq_epi32(_mm256_min_epu32(d, _mm256_set1_epi32(int(span))), d);
+        return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(in)));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        const uint32x4_t low = vdupq_n_u32(std::uint32_t(lo));
+        const uint32x4_t s = vdupq_n_u32(span);
+        const uint32x4_t d0 = vsubq_u32(vreinterpretq_u32_s32(vld1q_s32(p)), low);
+        const uint32x4_t d1 = vsubq_u32(vreinterpretq_u32_s32(vld1q_s32(p + 4)), low);
+        return laneBits(vcleq_u32(d0, s)) | laneBits(vcleq_u32(d1, s)) << 4;
+#else
+        unsigned bits = 0;
+        for (unsigned k = 0; k < 8; ++k) bits |= unsigned(std::uint32_t(p[k]) - std::uint32_t(lo) <= span) << k;
+        return bits;
+#endif
+    }
+
+#if !defined(__AVX2__) && defined(__ARM_NEON) && defined(__aarch64__)
+    // 4 all-ones/all-zeros lanes -> 4 bits
+    static unsigned laneBits(uint32x4_t mask) noexcept {
+        static const std::uint32_t weights[4] = {1, 2, 4, 8};
+        return vaddvq_u32(vandq_u32(mask, vld1q_u32(weights)));
+    }
+#endif
+
+    std::size_t capacity_;
+    std::size_t end_ = 0; // one past the highest index ever used
+    std::unique_ptr<int[]> ids_;
+    std::unique_ptr<std::string[]> names_;
+    std::unique_ptr<std::uint64_t[]> live_;
+    std::vector<std::size_t> free_;
+};
+
+} // namespace smartptrs